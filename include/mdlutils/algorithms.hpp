@@ -6,5 +6,6 @@
 #define MDLUTILS_ALGORITHMS_HPP
 
 #include <mdlutils/algorithms/top_of_n.hpp>
+#include <mdlutils/algorithms/parallel_top_of_n.hpp>
 
 #endif //MDLUTILS_ALGORITHMS_HPP
@@ -0,0 +1,129 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_ALGORITHMS_PARALLEL_TOP_OF_N_HPP
+#define MDLUTILS_ALGORITHMS_PARALLEL_TOP_OF_N_HPP
+
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mdlutils/exceptions/invalid_argument_exception.hpp>
+#include <mdlutils/multithreading/thread_pool.hpp>
+#include <mdlutils/types/range.hpp>
+
+namespace mdl
+{
+    namespace helper
+    {
+        // Reference to an element of the range, const for const iterators.
+        template<typename Iterator>
+        struct element_ref
+        {
+            typedef std::reference_wrapper<typename std::remove_reference<
+                    typename std::iterator_traits<Iterator>::reference>::type> type;
+        };
+
+        /* Select the top elements of [first, last) with a bounded heap, holding the worst of the selected elements
+         * at the front, so that most of the remaining elements are rejected with a single comparison.
+         *
+         * @return The selected elements, sorted best first.
+         */
+        template<typename RandomAccessIterator, typename Compare>
+        std::vector<typename element_ref<RandomAccessIterator>::type>
+        local_top_of_n(RandomAccessIterator first, RandomAccessIterator last, size_t elements, Compare comp)
+        {
+            typedef typename element_ref<RandomAccessIterator>::type ref_t;
+            std::vector<ref_t> heap;
+            heap.reserve(elements);
+            // With comp as the "less than", the heap keeps the worst selected element at the front
+            auto h_comp = [&comp](ref_t a, ref_t b) { return comp(a.get(), b.get()); };
+
+            for (; first != last && heap.size() < elements; ++first)
+                heap.push_back(*first);
+            std::make_heap(heap.begin(), heap.end(), h_comp);
+            for (; first != last; ++first)
+            {
+                if (!comp(*first, heap.front().get())) continue;
+                std::pop_heap(heap.begin(), heap.end(), h_comp);
+                heap.back() = *first;
+                std::push_heap(heap.begin(), heap.end(), h_comp);
+            }
+            std::sort_heap(heap.begin(), heap.end(), h_comp);
+            return heap;
+        }
+    }
+
+    /* Select the top elements of a range in parallel, using the workers of the pool.
+     * @pool Thread pool running the selection.
+     * @first Random access iterator pointing to the first element of the range (inkl.).
+     * @last Random access iterator pointing to the last element of the range (excl.).
+     * @elements Number of elements to select.
+     * @comp Comparator, the elements for which comp(a, b) holds against the others are selected first
+     *  (e.g. std::greater to select the largest elements).
+     *
+     * The range is split into a few chunks per worker, each chunk is reduced to its local top elements, and the
+     * partial results are combined with a k-way merge. Equivalent to <top_of_n_vector>, apart from the order of
+     * equivalent elements.
+     *
+     * @return Vector of references (const for const iterators) to the selected elements, sorted best first.
+     */
+    template<typename RandomAccessIterator, typename Compare>
+    inline std::vector<typename helper::element_ref<RandomAccessIterator>::type>
+    parallel_top_of_n(thread_pool &pool, RandomAccessIterator first, RandomAccessIterator last, size_t elements,
+                      Compare comp)
+    {
+        typedef typename helper::element_ref<RandomAccessIterator>::type ref_t;
+        typedef std::vector<ref_t> result_t;
+
+        size_t n = last - first;
+        if (n < elements)
+        {
+            mdl_throw(invalid_argument_exception<size_t>,
+                      "Number of elements greater than range size (" + std::to_string(n) + ")", "elements",
+                      elements);
+        }
+        if (elements == 0)
+            return result_t();
+
+        // A few chunks per worker, but each at least as long as the result, so that the merge stays cheap
+        size_t chunks = std::max<size_t>(1, std::min<size_t>(pool.workers * 4, n / elements));
+        std::vector<result_t> partials(chunks);
+        pool.parallel_for(range<size_t>(chunks), [&](size_t chunk)
+            {
+                RandomAccessIterator chunk_first = first + n * chunk / chunks;
+                RandomAccessIterator chunk_last = first + n * (chunk + 1) / chunks;
+                partials[chunk] = helper::local_top_of_n(chunk_first, chunk_last, elements, comp);
+            }, 1);
+
+        // k-way merge of the sorted partial results, with the cursor to the best remaining element at the front
+        typedef std::pair<typename result_t::const_iterator, typename result_t::const_iterator> cursor_t;
+        std::vector<cursor_t> cursors;
+        cursors.reserve(chunks);
+        for (const auto &partial : partials)
+            if (!partial.empty())
+                cursors.push_back(cursor_t(partial.begin(), partial.end()));
+        auto c_comp = [&comp](const cursor_t &a, const cursor_t &b) { return comp(b.first->get(), a.first->get()); };
+        std::make_heap(cursors.begin(), cursors.end(), c_comp);
+
+        result_t result;
+        result.reserve(elements);
+        while (result.size() < elements)
+        {
+            std::pop_heap(cursors.begin(), cursors.end(), c_comp);
+            cursor_t &best = cursors.back();
+            result.push_back(*best.first);
+            if (++best.first == best.second)
+                cursors.pop_back();
+            else
+                std::push_heap(cursors.begin(), cursors.end(), c_comp);
+        }
+        return result;
+    }
+}
+
+#endif //MDLUTILS_ALGORITHMS_PARALLEL_TOP_OF_N_HPP
@@ -6,8 +6,10 @@
 #define MDLUTILS_EXCEPTION_HPP
 
 #include <mdlutils/exceptions/base_exception.hpp>
+#include <mdlutils/exceptions/exception_list.hpp>
 #include <mdlutils/exceptions/invalid_argument_exception.hpp>
 #include <mdlutils/exceptions/invalid_state_exception.hpp>
 #include <mdlutils/exceptions/not_implemented_exception.hpp>
+#include <mdlutils/exceptions/operation_cancelled_exception.hpp>
 
 #endif //MDLUTILS_EXCEPTION_HPP
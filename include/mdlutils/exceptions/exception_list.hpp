@@ -0,0 +1,61 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_EXCEPTIONS_EXCEPTION_LIST_HPP
+#define MDLUTILS_EXCEPTIONS_EXCEPTION_LIST_HPP
+
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace mdl
+{
+    /* Exception aggregating the exceptions thrown by a group of tasks, e.g. the elements of <thread_pool::map>.
+     *
+     * Holds std::exception_ptr to each of the exceptions, which can be inspected with std::rethrow_exception.
+     */
+    class exception_list : public std::exception
+    {
+    protected:
+        std::vector<std::exception_ptr> exceptions;
+
+    public:
+        // A const random access iterator over the exceptions.
+        typedef std::vector<std::exception_ptr>::const_iterator iterator;
+        typedef iterator const_iterator;
+
+        // Create an empty list.
+        exception_list() { }
+
+        /* Create a list holding the given exceptions.
+         * @exceptions Pointers to the exceptions.
+         */
+        exception_list(std::vector<std::exception_ptr> exceptions) : exceptions(std::move(exceptions)) { }
+
+        /* Append an exception to the list.
+         * @exception Pointer to the exception.
+         */
+        void push_back(std::exception_ptr exception) { exceptions.push_back(std::move(exception)); }
+
+        // Number of exceptions in the list.
+        size_t size() const { return exceptions.size(); }
+
+        // Checks whether the list is empty.
+        bool empty() const { return exceptions.empty(); }
+
+        // Iterator to the first exception.
+        iterator begin() const { return exceptions.begin(); }
+
+        // Iterator past the last exception.
+        iterator end() const { return exceptions.end(); }
+
+        // Pointer to the n-th exception.
+        const std::exception_ptr &operator[](size_t n) const { return exceptions[n]; }
+
+        // @inherit
+        virtual const char *what() const noexcept { return "mdl::exception_list"; }
+    };
+}
+
+#endif //MDLUTILS_EXCEPTIONS_EXCEPTION_LIST_HPP
@@ -0,0 +1,40 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_EXCEPTIONS_OPERATION_CANCELLED_EXCEPTION_HPP
+#define MDLUTILS_EXCEPTIONS_OPERATION_CANCELLED_EXCEPTION_HPP
+
+#include <string>
+
+#include <mdlutils/exceptions/base_exception.hpp>
+
+namespace mdl
+{
+    /* Exception thrown by (or stored in place of the result of) a task that has been cancelled with a
+     * <cancellation_source>, either before it started or while polling its <cancellation_token>.
+     */
+    class operation_cancelled_exception : public base_exception
+    {
+    public:
+        /* Default constructor.
+         * @file Name of the file file in which exception has occurred.
+         * @line Line at which exception has occurred.
+         * @function The signature of the function that throws the exception.
+         * @msg Custom error message.
+         */
+        operation_cancelled_exception(const std::string &file, int line, const std::string &functionName,
+                                      const std::string &msg = "") :
+                base_exception(file, line, functionName, msg) { }
+
+    protected:
+        /// @inherit
+        virtual const std::string &tag() const
+        {
+            const static std::string tag = "OperationCancelledException";
+            return tag;
+        }
+    };
+}
+
+#endif //MDLUTILS_EXCEPTIONS_OPERATION_CANCELLED_EXCEPTION_HPP
@@ -0,0 +1,221 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MEMORY_ARENA_ALLOCATOR_HPP
+#define MDLUTILS_MEMORY_ARENA_ALLOCATOR_HPP
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+namespace mdl
+{
+    /* Arena of small memory blocks, backing <arena_allocator>.
+     *
+     * Blocks of up to <max_block_size> bytes are carved from large chunks with a bump pointer, and the freed blocks
+     * are kept in free lists (one per size class of <block_alignment> bytes) for reuse. Once the last live block is
+     * freed, e.g. when the container using the arena is cleared, the arena drops the free lists and releases all its
+     * chunks but one at once, so that no fragmentation survives the container's contents.
+     *
+     * Larger requests are forwarded to the global operator new/delete. The arena is not synchronized: it is meant
+     * to be owned by a single container (or a group of containers used by a single thread at a time).
+     */
+    class arena
+    {
+    public:
+        // Alignment of all blocks (and the granularity of size classes).
+        static const size_t block_alignment = 16;
+        // The largest request served from the arena.
+        static const size_t max_block_size = 1024;
+        // Default size of a chunk.
+        static const size_t default_chunk_size = 64 * 1024;
+
+    protected:
+        static const size_t size_classes = max_block_size / block_alignment;
+
+        struct chunk
+        {
+            chunk *next;
+            size_t size;
+        };
+
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        size_t chunk_size;
+        // The chunks, the most recent first, and the free space of the most recent one.
+        chunk *chunks = nullptr;
+        char *cursor = nullptr, *limit = nullptr;
+        free_block *free_lists[size_classes] = {};
+        // Number of blocks allocated from the chunks and not yet freed.
+        size_t live = 0;
+
+        // Allocate a new chunk, large enough for a block of the given size.
+        void grow(size_t bytes);
+
+        // Drop the free lists and all chunks but the most recent one, rewinding it.
+        void reset();
+
+    public:
+        /* Create an empty arena; no memory is allocated until the first request.
+         * @chunk_size Size of the chunks allocated from the global operator new.
+         */
+        explicit arena(size_t chunk_size = default_chunk_size) : chunk_size(chunk_size) { }
+
+        // Copy constructor, deleted.
+        arena(const arena &) = delete;
+
+        // Releases all chunks, the blocks still allocated become invalid.
+        ~arena() { release(); }
+
+        /* Allocate a block of memory of at least <bytes> bytes, aligned to <block_alignment>.
+         * @bytes Requested size.
+         *
+         * @return Pointer to the allocated memory, throws std::bad_alloc on failure.
+         */
+        void *allocate(size_t bytes);
+
+        /* Return a block obtained from <allocate> to the arena.
+         * @block Pointer returned by <allocate>.
+         * @bytes The size passed to <allocate>.
+         */
+        void deallocate(void *block, size_t bytes);
+
+        /* Release all chunks to the global operator delete, invalidating all blocks still allocated. */
+        void release();
+
+        // Number of blocks allocated from the chunks and not yet freed.
+        size_t live_blocks() const { return live; }
+
+        // Total size of the chunks held by the arena.
+        size_t capacity() const;
+    };
+
+    /* Allocator serving small objects from an <arena>, shared by the copies (and rebound copies) of the allocator.
+     * @T Type of allocated objects, can't be over-aligned.
+     *
+     * A default-constructed allocator creates a new arena, and so does copying a container using it (see
+     * <select_on_container_copy_construction>), so each container gets an arena of its own: its nodes are packed
+     * in a few chunks, and clearing the container releases them at once. Suited for node-based containers used by
+     * a single thread at a time, e.g. <sorted_list>; use <pool_allocator> for objects passed between threads.
+     *
+     * Copies and moves of the allocator itself share the arena, as the allocator requirements demand that the
+     * moved-from allocator stays equal to the new one. Hence a moved-to container shares the arena with the
+     * moved-from one, and the two may only be used by one thread at a time, until the moved-from container is
+     * destroyed. To hand the elements over to another thread and keep using the container, copy it instead.
+     */
+    template<typename T>
+    class arena_allocator
+    {
+        static_assert(alignof(T) <= mdl::arena::block_alignment, "arena_allocator does not support over-aligned types");
+
+        template<typename U> friend class arena_allocator;
+
+        std::shared_ptr<mdl::arena> pool;
+
+    public:
+        // The template parameter.
+        typedef T value_type;
+        // value_type*
+        typedef T *pointer;
+        // const value_type*
+        typedef const T *const_pointer;
+        // value_type&
+        typedef T &reference;
+        // const value_type&
+        typedef const T &const_reference;
+        // An unsigned integral type representing the size of the allocations.
+        typedef size_t size_type;
+        // A signed integral type representing the differences between the pointers.
+        typedef ptrdiff_t difference_type;
+
+        // The containers move and swap the arena along with their elements.
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        // Rebind the allocator to another type.
+        template<typename U>
+        struct rebind
+        {
+            typedef arena_allocator<U> other;
+        };
+
+        // Default constructor, creating a new arena.
+        arena_allocator() : pool(std::make_shared<mdl::arena>()) { }
+
+        /* Create an allocator using the given arena.
+         * @arena The arena to allocate from.
+         */
+        explicit arena_allocator(std::shared_ptr<mdl::arena> arena) : pool(std::move(arena)) { }
+
+        arena_allocator(const arena_allocator &other) noexcept = default;
+
+        // Move constructor, sharing the arena, so that the moved-from allocator (and its container) stays usable from
+        // the same thread.
+        arena_allocator(arena_allocator &&other) noexcept : pool(other.pool) { }
+
+        arena_allocator &operator=(const arena_allocator &other) noexcept = default;
+
+        arena_allocator &operator=(arena_allocator &&other) noexcept
+        {
+            pool = other.pool;
+            return *this;
+        }
+
+        // Converting constructor, sharing the arena.
+        template<typename U>
+        arena_allocator(const arena_allocator<U> &other) noexcept : pool(other.pool) { }
+
+        // The arena used by the allocator.
+        const std::shared_ptr<mdl::arena> &arena() const { return pool; }
+
+        // Allocator for a copy of the container, with an arena of its own.
+        arena_allocator select_on_container_copy_construction() const
+        {
+            return arena_allocator();
+        }
+
+        /* Allocate uninitialized storage for n objects of type T.
+         * @n Number of objects.
+         *
+         * @return Pointer to the storage.
+         */
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(pool->allocate(n * sizeof(T)));
+        }
+
+        /* Release the storage obtained from <allocate>.
+         * @p Pointer to the storage.
+         * @n Number of objects, has to match the value passed to <allocate>.
+         */
+        void deallocate(T *p, size_t n)
+        {
+            pool->deallocate(p, n * sizeof(T));
+        }
+
+        // The largest supported allocation.
+        size_t max_size() const noexcept { return size_t(-1) / sizeof(T); }
+
+        template<typename U, typename... Args>
+        void construct(U *p, Args &&... args)
+        {
+            ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template<typename U>
+        void destroy(U *p) { p->~U(); }
+
+        template<typename U>
+        bool operator==(const arena_allocator<U> &other) const { return pool == other.pool; }
+
+        template<typename U>
+        bool operator!=(const arena_allocator<U> &other) const { return pool != other.pool; }
+    };
+}
+
+#endif //MDLUTILS_MEMORY_ARENA_ALLOCATOR_HPP
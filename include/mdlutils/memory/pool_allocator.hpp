@@ -0,0 +1,134 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MEMORY_POOL_ALLOCATOR_HPP
+#define MDLUTILS_MEMORY_POOL_ALLOCATOR_HPP
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Thread-caching pool of small memory blocks, backing <pool_allocator>.
+         *
+         * Requests of up to <max_block_size> bytes are rounded up to a multiple of <block_alignment> and served
+         * from per-thread free lists, one per size class. The lists are refilled with whole slabs of blocks, so
+         * in the steady state neither allocation nor deallocation calls the global operator new/delete.
+         *
+         * Blocks freed by a thread other than the one which allocated them are returned to their owner through
+         * a lock-free stack, which the owner takes over once its local list runs out. Per-thread pools are never
+         * destroyed; when a thread exits, its pool is adopted by the next thread that needs one.
+         *
+         * Larger requests are forwarded to the global operator new/delete.
+         */
+        struct block_pool
+        {
+            // Alignment of all blocks (and the granularity of size classes).
+            static const size_t block_alignment = 16;
+            // The largest request served from the pool.
+            static const size_t max_block_size = 1024;
+            // Number of blocks carved at once from a newly allocated slab.
+            static const size_t blocks_per_slab = 64;
+
+            /* Allocate a block of memory of at least <bytes> bytes, aligned to <block_alignment>.
+             * @bytes Requested size.
+             *
+             * @return Pointer to the allocated memory, throws std::bad_alloc on failure.
+             */
+            static void *allocate(size_t bytes);
+
+            /* Return a block obtained from <allocate> to the pool.
+             * @block Pointer returned by <allocate>.
+             * @bytes The size passed to <allocate>.
+             */
+            static void deallocate(void *block, size_t bytes);
+        };
+    }
+
+    /* Allocator serving small objects from thread-cached pools of fixed size blocks (see <helper::block_pool>).
+     * @T Type of allocated objects, can't be over-aligned.
+     *
+     * Instances are stateless and always compare equal, so memory allocated by one may be released by another,
+     * including on a different thread. Suited for node-based containers and short-lived objects passed between
+     * threads, e.g. messages and tasks.
+     */
+    template<typename T>
+    class pool_allocator
+    {
+        static_assert(alignof(T) <= helper::block_pool::block_alignment, "pool_allocator does not support over-aligned types");
+
+    public:
+        // The template parameter.
+        typedef T value_type;
+        // value_type*
+        typedef T *pointer;
+        // const value_type*
+        typedef const T *const_pointer;
+        // value_type&
+        typedef T &reference;
+        // const value_type&
+        typedef const T &const_reference;
+        // An unsigned integral type representing the size of the allocations.
+        typedef size_t size_type;
+        // A signed integral type representing the differences between the pointers.
+        typedef ptrdiff_t difference_type;
+
+        // Rebind the allocator to another type.
+        template<typename U>
+        struct rebind
+        {
+            typedef pool_allocator<U> other;
+        };
+
+        // Default constructor.
+        pool_allocator() noexcept { }
+
+        // Converting constructor.
+        template<typename U>
+        pool_allocator(const pool_allocator<U> &) noexcept { }
+
+        /* Allocate uninitialized storage for n objects of type T.
+         * @n Number of objects.
+         *
+         * @return Pointer to the storage.
+         */
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(helper::block_pool::allocate(n * sizeof(T)));
+        }
+
+        /* Release the storage obtained from <allocate>.
+         * @p Pointer to the storage.
+         * @n Number of objects, has to match the value passed to <allocate>.
+         */
+        void deallocate(T *p, size_t n)
+        {
+            helper::block_pool::deallocate(p, n * sizeof(T));
+        }
+
+        // The largest supported allocation.
+        size_t max_size() const noexcept { return size_t(-1) / sizeof(T); }
+
+        template<typename U, typename... Args>
+        void construct(U *p, Args &&... args)
+        {
+            ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template<typename U>
+        void destroy(U *p) { p->~U(); }
+    };
+
+    template<typename T, typename U>
+    bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) { return true; }
+
+    template<typename T, typename U>
+    bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) { return false; }
+}
+
+#endif //MDLUTILS_MEMORY_POOL_ALLOCATOR_HPP
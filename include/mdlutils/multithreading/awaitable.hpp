@@ -0,0 +1,50 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_AWAITABLE_HPP
+#define MDLUTILS_MULTITHREADING_AWAITABLE_HPP
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Task resuming a suspended coroutine, used by the awaiters of <looper>, <thread_pool> and <future>.
+         * @Handle Type of the coroutine handle (e.g. std::coroutine_handle<>).
+         *
+         * The awaiters only need the handle as a template parameter, so they are available without C++20; see
+         * coroutine.hpp for the coroutine support itself. If the task is dropped without being run (e.g. by
+         * <thread_pool::shutdown> with cancel_pending), the coroutine is destroyed instead of being leaked.
+         */
+        template<typename Handle>
+        class resume_call
+        {
+            Handle handle;
+            bool pending;
+
+        public:
+            explicit resume_call(Handle handle) : handle(handle), pending(true) { }
+
+            resume_call(const resume_call &) = delete;
+
+            resume_call(resume_call &&other) noexcept : handle(other.handle), pending(other.pending)
+            {
+                other.pending = false;
+            }
+
+            ~resume_call()
+            {
+                if (pending)
+                    handle.destroy();
+            }
+
+            void operator()()
+            {
+                pending = false;
+                handle.resume();
+            }
+        };
+    }
+}
+
+#endif //MDLUTILS_MULTITHREADING_AWAITABLE_HPP
@@ -0,0 +1,85 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_CANCELLATION_HPP
+#define MDLUTILS_MULTITHREADING_CANCELLATION_HPP
+
+#include <atomic>
+#include <memory>
+
+#include <mdlutils/exceptions/operation_cancelled_exception.hpp>
+#include <mdlutils/memory/pool_allocator.hpp>
+
+namespace mdl
+{
+    namespace helper
+    {
+        // State shared by a <cancellation_source> and its tokens.
+        struct cancellation_state
+        {
+            std::atomic<bool> cancelled{false};
+        };
+    }
+
+    /* Read-only view of a cancellation request, passed along with the tasks.
+     *
+     * Queued tasks holding a cancelled token are dropped by the executor instead of being run, while running tasks
+     * may poll <is_cancelled> (or call <throw_if_cancelled>) to stop early. A default-constructed token can never
+     * be cancelled. Tokens are cheap to copy and may be used from any thread.
+     */
+    class cancellation_token
+    {
+    protected:
+        std::shared_ptr<helper::cancellation_state> state;
+
+        explicit cancellation_token(std::shared_ptr<helper::cancellation_state> state) : state(std::move(state)) { }
+
+        friend class cancellation_source;
+
+    public:
+        // Create a token that is never cancelled.
+        cancellation_token() { }
+
+        // Checks whether the token is associated with a <cancellation_source>, i.e. whether it may ever be cancelled.
+        bool can_be_cancelled() const { return state != nullptr; }
+
+        // Checks whether the cancellation has been requested.
+        bool is_cancelled() const { return state && state->cancelled.load(std::memory_order_acquire); }
+
+        // Throw <operation_cancelled_exception> if the cancellation has been requested.
+        void throw_if_cancelled() const
+        {
+            if (is_cancelled())
+                mdl_throw(operation_cancelled_exception, "Operation cancelled");
+        }
+    };
+
+    /* Owner of a cancellation request, handing out <cancellation_token>s.
+     *
+     * Copies of a source share the same state, so any of them can cancel all of the tokens.
+     */
+    class cancellation_source
+    {
+    protected:
+        std::shared_ptr<helper::cancellation_state> state;
+
+    public:
+        // Create a new, not cancelled, source.
+        cancellation_source() :
+                state(std::allocate_shared<helper::cancellation_state>(pool_allocator<helper::cancellation_state>())) { }
+
+        // Token observing this source.
+        cancellation_token token() const { return cancellation_token(state); }
+
+        /* Request the cancellation of all operations holding a token of this source. Never blocks, and has no
+         * effect if already cancelled.
+         */
+        void cancel() { state->cancelled.store(true, std::memory_order_release); }
+
+        // Checks whether the cancellation has been requested.
+        bool is_cancelled() const { return state->cancelled.load(std::memory_order_acquire); }
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_CANCELLATION_HPP
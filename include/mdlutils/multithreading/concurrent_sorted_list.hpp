@@ -0,0 +1,552 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_CONCURRENT_SORTED_LIST_HPP
+#define MDLUTILS_MULTITHREADING_CONCURRENT_SORTED_LIST_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Test-and-test-and-set lock guarding a single node, yielding while it is taken. */
+        class spin_lock
+        {
+            std::atomic<bool> locked{false};
+
+        public:
+            void lock()
+            {
+                while (locked.exchange(true, std::memory_order_acquire))
+                    while (locked.load(std::memory_order_relaxed))
+                        std::this_thread::yield();
+            }
+
+            void unlock() { locked.store(false, std::memory_order_release); }
+        };
+    }
+
+    /* Thread-safe, std::multiset-emulating class, based on a lazy skip list with per-node locks.
+     * @T Type of the elements.
+     * @Compare A binary predicate that takes two arguments of the same type as the elements and returns a bool.
+     * @Alloc Type of the allocator object, rebound to allocate the nodes.
+     *
+     * The implementation follows "A Simple Optimistic Skiplist Algorithm" (Herlihy, Lev, Luchangco, Shavit,
+     * SIROCCO 2007), extended to equivalent elements: a new element is linked after the equivalent ones. Lookups
+     * and iteration take no locks. Insertion and erasure search without locks, then lock and validate only the
+     * predecessors of the node, so operations on different parts of the list do not contend.
+     *
+     * An element is erased by marking its node (the linearization point) and then unlinking it. Unlinked nodes are
+     * retired, not freed, since concurrent readers may still be traversing them; they are freed by <collect> or
+     * the destructor. Iterators therefore stay dereferenceable until then, and the iteration is weakly consistent:
+     * it skips the erased elements, and may or may not see the elements inserted concurrently. An end iterator
+     * obtained separately (e.g. from <upper_bound>) is skipped as well if its element is erased concurrently, so the
+     * ranges should be walked to end(), or obtained from <equal_range>.
+     */
+    template<typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>>
+    class concurrent_sorted_list
+    {
+    protected:
+        // Maximal height of a node, enough for about promotion^max_levels elements.
+        static constexpr size_t max_levels = 16;
+        // One in promotion nodes of a level is linked on the next level as well.
+        static constexpr unsigned promotion = 4;
+
+        struct node
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            size_t height;
+            // Set when the element is erased, before the node is unlinked.
+            std::atomic<bool> marked;
+            // Set when the node is linked on all of its levels.
+            std::atomic<bool> fully_linked;
+            helper::spin_lock lock;
+            // Link in the list of retired nodes.
+            node *retired_next;
+            // Links on each of the levels, the node is allocated with room for <height> of them.
+            std::atomic<node *> next[1];
+
+            node(size_t height) : height(height), marked(false), fully_linked(false), retired_next(nullptr)
+            {
+                next[0].store(nullptr, std::memory_order_relaxed);
+                for (size_t level = 1; level < height; ++level)
+                    ::new(next + level) std::atomic<node *>(nullptr);
+            }
+
+            T &value() { return *reinterpret_cast<T *>(&storage); }
+        };
+
+        typedef typename std::aligned_storage<sizeof(node *), alignof(node)>::type word_t;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<word_t> word_alloc_t;
+        typedef std::allocator_traits<word_alloc_t> word_traits;
+
+        Compare comp;
+        word_alloc_t word_alloc;
+        // Sentinel in front of all the elements, holding no value; nullptr stands for the end of all levels.
+        node *head;
+        std::atomic<size_t> elements{0};
+        // Nodes unlinked by <erase>, freed by <collect>.
+        std::atomic<node *> retired{nullptr};
+
+    public:
+        // The second template parameter.
+        typedef Compare key_compare;
+        // The second template parameter.
+        typedef Compare value_compare;
+        // The first template parameter.
+        typedef T key_type;
+        // The first template parameter.
+        typedef T value_type;
+        // The third template parameter
+        typedef Alloc allocator_type;
+        // An unsigned integral type representing the size of the container.
+        typedef size_t size_type;
+
+        // A forward iterator to const value_type, skipping the erased elements.
+        class iterator
+        {
+            friend class concurrent_sorted_list;
+
+            node *current;
+            // For the ranges of <equal_range>: the first node of the range, the end of the range, and the comparator.
+            // The iteration jumps to the end once past the equivalent elements, even if the end has been erased.
+            node *range_first, *range_end;
+            const Compare *comp;
+
+            // Skip the nodes that are erased or not yet fully linked.
+            static node *live(node *n)
+            {
+                while (n && (n->marked.load(std::memory_order_acquire) ||
+                             !n->fully_linked.load(std::memory_order_acquire)))
+                    n = n->next[0].load(std::memory_order_acquire);
+                return n;
+            }
+
+            explicit iterator(node *current) :
+                    current(current), range_first(nullptr), range_end(nullptr), comp(nullptr) { }
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const T *pointer;
+            typedef const T &reference;
+
+            iterator() : iterator(nullptr) { }
+
+            reference operator*() const { return current->value(); }
+
+            pointer operator->() const { return &current->value(); }
+
+            iterator &operator++()
+            {
+                current = live(current->next[0].load(std::memory_order_acquire));
+                if (range_first && (!current || (*comp)(range_first->value(), current->value())))
+                    current = range_end;
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const iterator &other) const { return current == other.current; }
+
+            bool operator!=(const iterator &other) const { return current != other.current; }
+        };
+
+        typedef iterator const_iterator;
+
+    protected:
+        // Size of a node of the given height, in words.
+        static size_t words_for(size_t height)
+        {
+            return (sizeof(node) + (height - 1) * sizeof(std::atomic<node *>) + sizeof(word_t) - 1) / sizeof(word_t);
+        }
+
+        node *new_node(size_t height)
+        {
+            return ::new(static_cast<void *>(word_traits::allocate(word_alloc, words_for(height)))) node(height);
+        }
+
+        // Free the node, destroying the value unless with_value is false.
+        void free_node(node *n, bool with_value = true)
+        {
+            size_t words = words_for(n->height);
+            if (with_value && n != head)
+                n->value().~T();
+            n->~node();
+            word_traits::deallocate(word_alloc, reinterpret_cast<word_t *>(n), words);
+        }
+
+        // Height of a new node, at least 1, drawn from a per-thread generator (xorshift64*).
+        static size_t random_height()
+        {
+            static thread_local uint64_t state =
+                    0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            uint64_t bits = state * 0x2545F4914F6CDD1Dull;
+            size_t height = 1;
+            for (; height < max_levels && bits % promotion == 0; bits /= promotion)
+                ++height;
+            return height;
+        }
+
+        /* Find the last node, on each level, before the bound of the value, and the node following it.
+         * @upper Whether to look for the nodes not greater than the value (or smaller than the value).
+         */
+        void search(const T &value, bool upper, node **preds, node **succs) const
+        {
+            node *pred = head;
+            for (size_t level = max_levels; level-- > 0;)
+            {
+                node *curr = pred->next[level].load(std::memory_order_acquire);
+                while (curr && (upper ? !comp(value, curr->value()) : comp(curr->value(), value)))
+                {
+                    pred = curr;
+                    curr = pred->next[level].load(std::memory_order_acquire);
+                }
+                preds[level] = pred;
+                succs[level] = curr;
+            }
+        }
+
+        // The first node on the lowest level at the bound of the value (skipping no nodes).
+        node *bound(const T &value, bool upper) const
+        {
+            node *pred = head;
+            node *curr = nullptr;
+            for (size_t level = max_levels; level-- > 0;)
+            {
+                curr = pred->next[level].load(std::memory_order_acquire);
+                while (curr && (upper ? !comp(value, curr->value()) : comp(curr->value(), value)))
+                {
+                    pred = curr;
+                    curr = pred->next[level].load(std::memory_order_acquire);
+                }
+            }
+            return curr;
+        }
+
+        // Unlock the distinct predecessors locked on the levels [0, levels).
+        static void unlock(node **preds, size_t levels)
+        {
+            for (size_t level = 0; level < levels; ++level)
+                if (level == 0 || preds[level] != preds[level - 1])
+                    preds[level]->lock.unlock();
+        }
+
+        void retire(node *n)
+        {
+            n->retired_next = retired.load(std::memory_order_relaxed);
+            while (!retired.compare_exchange_weak(n->retired_next, n, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+
+        bool equiv(node *n, const T &value) const
+        {
+            return !(comp(n->value(), value) || comp(value, n->value()));
+        }
+
+        // Erase the element of the node, unless some other thread has erased it first.
+        bool remove(node *victim)
+        {
+            while (!victim->fully_linked.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            victim->lock.lock();
+            if (victim->marked.load(std::memory_order_relaxed))
+            {
+                victim->lock.unlock();
+                return false;
+            }
+            victim->marked.store(true, std::memory_order_release);
+
+            const T &value = victim->value();
+            const size_t height = victim->height;
+            node *preds[max_levels], *succs[max_levels];
+            while (true)
+            {
+                // The predecessors of the victim may follow the equivalent elements preceding it
+                search(value, false, preds, succs);
+                bool found = true;
+                for (size_t level = 0; found && level < height; ++level)
+                {
+                    node *next;
+                    while ((next = preds[level]->next[level].load(std::memory_order_acquire)) != victim)
+                    {
+                        if (!next || comp(value, next->value()))
+                        {
+                            found = false;
+                            break;
+                        }
+                        preds[level] = next;
+                    }
+                }
+                if (!found)
+                    continue;
+
+                size_t locked = 0;
+                bool valid = true;
+                for (; valid && locked < height; ++locked)
+                {
+                    node *pred = preds[locked];
+                    if (locked == 0 || pred != preds[locked - 1])
+                        pred->lock.lock();
+                    valid = !pred->marked.load(std::memory_order_acquire) &&
+                            pred->next[locked].load(std::memory_order_acquire) == victim;
+                }
+                if (valid)
+                {
+                    for (size_t level = height; level-- > 0;)
+                        preds[level]->next[level].store(victim->next[level].load(std::memory_order_relaxed),
+                                                        std::memory_order_release);
+                    victim->lock.unlock();
+                    unlock(preds, locked);
+                    retire(victim);
+                    elements.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+                unlock(preds, locked);
+            }
+        }
+
+    public:
+        /* Default, empty constructor.
+         * @comp Comparator object.
+         * @alloc Allocator object.
+         */
+        concurrent_sorted_list(const key_compare &comp = key_compare(),
+                               const allocator_type &alloc = allocator_type()) :
+                comp(comp), word_alloc(alloc), head(new_node(max_levels))
+        {
+            head->fully_linked.store(true, std::memory_order_relaxed);
+        }
+
+        // Copy constructor, deleted.
+        concurrent_sorted_list(const concurrent_sorted_list &) = delete;
+
+        // Destructor, releases all nodes, including the retired ones.
+        ~concurrent_sorted_list()
+        {
+            collect();
+            for (node *n = head; n;)
+            {
+                node *next = n->next[0].load(std::memory_order_relaxed);
+                free_node(n);
+                n = next;
+            }
+        }
+
+        /* Insert element, after the elements equivalent to it. Thread-safe.
+         * @value the value to be inserted.
+         *
+         * @return an iterator that points to the inserted element.
+         */
+        iterator insert(const T &value) { return emplace(value); }
+
+        /* Insert element, after the elements equivalent to it. Thread-safe.
+         * @value the value to be inserted.
+         *
+         * @return an iterator that points to the inserted element.
+         */
+        iterator insert(T &&value) { return emplace(std::move(value)); }
+
+        /* Create and insert a new element, after the elements equivalent to it. Thread-safe.
+         * @args the values to be passed to the constructor.
+         *
+         * @return an iterator that points to the inserted element.
+         */
+        template<typename... Args>
+        iterator emplace(Args &&... args)
+        {
+            const size_t height = random_height();
+            node *fresh = new_node(height);
+            try
+            {
+                ::new(&fresh->storage) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                free_node(fresh, false);
+                throw;
+            }
+
+            const T &value = fresh->value();
+            node *preds[max_levels], *succs[max_levels];
+            while (true)
+            {
+                search(value, true, preds, succs);
+
+                size_t locked = 0;
+                bool valid = true;
+                for (; valid && locked < height; ++locked)
+                {
+                    node *pred = preds[locked], *succ = succs[locked];
+                    if (locked == 0 || pred != preds[locked - 1])
+                        pred->lock.lock();
+                    valid = !pred->marked.load(std::memory_order_acquire) &&
+                            (!succ || !succ->marked.load(std::memory_order_acquire)) &&
+                            pred->next[locked].load(std::memory_order_acquire) == succ;
+                }
+                if (!valid)
+                {
+                    unlock(preds, locked);
+                    continue;
+                }
+
+                for (size_t level = 0; level < height; ++level)
+                    fresh->next[level].store(succs[level], std::memory_order_relaxed);
+                for (size_t level = 0; level < height; ++level)
+                    preds[level]->next[level].store(fresh, std::memory_order_release);
+                fresh->fully_linked.store(true, std::memory_order_release);
+                unlock(preds, locked);
+                elements.fetch_add(1, std::memory_order_relaxed);
+                return iterator(fresh);
+            }
+        }
+
+        /* Erase the elements equivalent to value. Thread-safe.
+         * @value value to be removed from the set.
+         *
+         * @return the number of elements removed by this call.
+         */
+        size_t erase(const T &value)
+        {
+            size_t removed = 0;
+            while (true)
+            {
+                node *n = iterator::live(bound(value, false));
+                if (!n || !equiv(n, value))
+                    return removed;
+                if (remove(n))
+                    ++removed;
+            }
+        }
+
+        /* Erase element. Thread-safe.
+         * @position iterator pointing to a single element to be removed.
+         *
+         * @return true, if the element was erased by this call (and not by a concurrent one).
+         */
+        bool erase(iterator position) { return remove(position.current); }
+
+        /* Erase all elements. Thread-safe, the elements inserted concurrently may or may not be erased. */
+        void clear()
+        {
+            for (iterator it = begin(), last = end(); it != last; ++it)
+                remove(it.current);
+        }
+
+        /* Free the nodes of the erased elements.
+         *
+         * Must not be called concurrently with any other operation, and invalidates the iterators to the erased
+         * elements.
+         */
+        void collect()
+        {
+            for (node *n = retired.exchange(nullptr, std::memory_order_acquire); n;)
+            {
+                node *next = n->retired_next;
+                free_node(n);
+                n = next;
+            }
+        }
+
+        /* Searches the list for the first element equivalent to <value>. Thread-safe.
+         * @value key of the element to search for.
+         *
+         * @return valid iterator to the first element found, or <end()> if the element was not found.
+         */
+        iterator find(const T &value) const
+        {
+            node *n = iterator::live(bound(value, false));
+            return iterator(n && equiv(n, value) ? n : nullptr);
+        }
+
+        /* Searches the container for elements equivalent to value and returns the number of matches. Thread-safe.
+         * @value key of the element to search for.
+         *
+         * @return number of elements in the container that are equivalent to <value>.
+         */
+        size_t count(const T &value) const
+        {
+            std::pair<iterator, iterator> range = equal_range(value);
+            return std::distance(range.first, range.second);
+        }
+
+        /* Returns the iterator for the first element not smaller than value. Thread-safe.
+         * @value key of the element to search for.
+         */
+        iterator lower_bound(const T &value) const { return iterator(iterator::live(bound(value, false))); }
+
+        /* Returns the iterator for the first element greater than value. Thread-safe.
+         * @value key of the element to search for.
+         */
+        iterator upper_bound(const T &value) const { return iterator(iterator::live(bound(value, true))); }
+
+        /* Returns the bounds of a range that includes all the elements in the container that are equivalent to <value>.
+         * @value key of the element to search for.
+         *
+         * @return a pair of <lower_bound> and <upper_bound>. Thread-safe: the iteration from the first to the second
+         *  iterator visits only the equivalent elements and reaches the second one, even if it is erased meanwhile.
+         */
+        std::pair<iterator, iterator> equal_range(const T &value) const
+        {
+            iterator first = lower_bound(value);
+            if (!first.current || !equiv(first.current, value))
+                return std::make_pair(first, first);
+
+            iterator last = upper_bound(value);
+            first.range_first = first.current;
+            first.range_end = last.current;
+            first.comp = &comp;
+            return std::make_pair(first, last);
+        }
+
+        // Return an iterator to the first element of the sequence
+        iterator begin() const { return iterator(iterator::live(head->next[0].load(std::memory_order_acquire))); }
+
+        // Return an iterator to the element after the last element of the sequence
+        iterator end() const { return iterator(nullptr); }
+
+        // Return an iterator to the first element of the sequence
+        const_iterator cbegin() const { return begin(); }
+
+        // Return an iterator to the element after the last element of the sequence
+        const_iterator cend() const { return end(); }
+
+        /* Returns the number of elements in the list; may be out of date if the list is modified concurrently. */
+        size_t size() const { return elements.load(std::memory_order_relaxed); }
+
+        /* Checks, whether the list is empty; may be out of date if the list is modified concurrently. */
+        bool empty() const { return size() == 0; }
+
+        /* Returns a copy of the comparison object used by the container. */
+        Compare key_comp() const { return comp; }
+
+        /* Returns a copy of the comparison object used by the container. */
+        Compare value_comp() const { return comp; }
+
+        /* Returns a copy of the allocator object used by the container. */
+        Alloc get_allocator() const { return Alloc(word_alloc); }
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_CONCURRENT_SORTED_LIST_HPP
@@ -0,0 +1,81 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_COROUTINE_HPP
+#define MDLUTILS_MULTITHREADING_COROUTINE_HPP
+
+/* C++20 coroutine support. The rest of the library stays C++11; the awaiters (<looper::schedule>,
+ * <looper::schedule_after>, <thread_pool::schedule> and <future> itself) are plain classes, while this header adds
+ * the coroutine return type, so it has to be compiled as C++20 (see MDLUTILS_COROUTINES in CMakeLists.txt).
+ */
+#if !defined(__cpp_impl_coroutine)
+#error "mdlutils/multithreading/coroutine.hpp requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include <mdlutils/multithreading/future.hpp>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Promise type of the coroutines returning <future>, fulfilling an <mdl::promise> with the result of the
+         * coroutine, or with the exception escaping it.
+         * @T Result type.
+         *
+         * The coroutine starts right away, on the calling thread, and the frame is released as soon as it finishes.
+         * Its continuations are run in place (the promise has no executor), i.e. on the thread finishing the
+         * coroutine.
+         */
+        template<typename T>
+        struct future_coroutine_base
+        {
+            mdl::promise<T> result;
+
+            future<T> get_return_object() { return result.get_future(); }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            std::suspend_never final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() { result.set_exception(std::current_exception()); }
+        };
+
+        template<typename T>
+        struct future_coroutine_promise : future_coroutine_base<T>
+        {
+            template<typename U>
+            void return_value(U &&value) { this->result.set_value(std::forward<U>(value)); }
+        };
+
+        template<>
+        struct future_coroutine_promise<void> : future_coroutine_base<void>
+        {
+            void return_void() { this->result.set_value(); }
+        };
+    }
+}
+
+/* Lets any function returning mdl::future<T> be a coroutine, e.g.:
+ *
+ *     mdl::future<int> pipeline(mdl::thread_pool &pool)
+ *     {
+ *         co_await pool.schedule();                 // continue on a worker
+ *         int a = co_await pool.async(compute, 1);  // no worker is blocked while waiting
+ *         co_return a + 1;
+ *     }
+ */
+namespace std
+{
+    template<typename T, typename... Args>
+    struct coroutine_traits<mdl::future<T>, Args...>
+    {
+        typedef mdl::helper::future_coroutine_promise<T> promise_type;
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_COROUTINE_HPP
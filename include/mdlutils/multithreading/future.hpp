@@ -0,0 +1,709 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_FUTURE_HPP
+#define MDLUTILS_MULTITHREADING_FUTURE_HPP
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <type_traits>
+#include <condition_variable>
+
+#include <mdlutils/exceptions/exception_list.hpp>
+#include <mdlutils/memory/pool_allocator.hpp>
+#include <mdlutils/multithreading/awaitable.hpp>
+#include <mdlutils/multithreading/task.hpp>
+
+namespace mdl
+{
+    /* Interface of objects running tasks, e.g. <thread_pool>. Used by <future::then> to schedule continuations. */
+    class executor
+    {
+    public:
+        /* Run the task at some point, possibly on another thread.
+         * @t The task to run.
+         */
+        virtual void execute(task t) = 0;
+
+        virtual ~executor() { }
+    };
+
+    /* Lifetime-safe reference to an <executor>, held by the shared states of the futures it runs continuations for.
+     *
+     * The executor detaches the handle once it stops accepting tasks (e.g. on shutdown, or in its destructor), after
+     * which <execute> refuses the tasks, and the continuations are run by the thread that schedules them instead.
+     */
+    class executor_handle
+    {
+        executor *target;
+        std::atomic_bool attached{true};
+        // Number of threads in <execute>, waited for by <detach>.
+        std::atomic<unsigned> users{0};
+
+    public:
+        explicit executor_handle(executor *target) : target(target) { }
+
+        executor_handle(const executor_handle &) = delete;
+
+        /* Hand the task over to the executor, unless it has been detached.
+         * @t The task, moved from only if it has been accepted.
+         *
+         * @return true if the executor took the task, false if the caller has to run it.
+         */
+        bool execute(task &t)
+        {
+            struct user_guard
+            {
+                std::atomic<unsigned> &users;
+
+                ~user_guard() { --users; }
+            } guard{users};
+            ++users;
+            if (!attached.load())
+                return false;
+            target->execute(std::move(t));
+            return true;
+        }
+
+        // Refuse the subsequent tasks, and wait for the ones being handed over at the moment.
+        void detach()
+        {
+            attached.store(false);
+            while (users.load() != 0)
+                std::this_thread::yield();
+        }
+    };
+
+    template<typename T>
+    class future;
+
+    template<typename T>
+    class promise;
+
+    namespace helper
+    {
+        /* Part of the state shared by a <promise> and a <future>, independent of the result type.
+         *
+         * Besides blocking waits, allows registering callbacks run (on the thread fulfilling the promise) once the
+         * result is set, which is what continuations and <when_all> / <when_any> are built on.
+         */
+        class shared_state_base
+        {
+        protected:
+            std::mutex lock;
+            std::condition_variable ready_cv;
+            bool ready = false;
+            std::exception_ptr error;
+            std::vector<task, pool_allocator<task>> callbacks;
+
+            // Mark the state as ready (the result has to be stored already) and run the callbacks.
+            void complete(std::unique_lock<std::mutex> &scope_lock)
+            {
+                ready = true;
+                std::vector<task, pool_allocator<task>> pending(std::move(callbacks));
+                scope_lock.unlock();
+                ready_cv.notify_all();
+                for (auto &callback : pending)
+                    callback();
+            }
+
+            // Throw std::future_error, if the result has already been set. Has to be called under the lock.
+            void check_unsatisfied() const
+            {
+                if (ready)
+                    throw std::future_error(std::future_errc::promise_already_satisfied);
+            }
+
+        public:
+            // The executor running the continuations, if nullptr (or detached) they are run in place.
+            const std::shared_ptr<executor_handle> exec;
+
+            shared_state_base(std::shared_ptr<executor_handle> exec) : exec(std::move(exec)) { }
+
+            shared_state_base(const shared_state_base &) = delete;
+
+            bool is_ready()
+            {
+                std::lock_guard<std::mutex> scope_lock(lock);
+                return ready;
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> scope_lock(lock);
+                ready_cv.wait(scope_lock, [this]() { return ready; });
+            }
+
+            template<typename Rep, typename Period>
+            bool wait_for(const std::chrono::duration<Rep, Period> &duration)
+            {
+                std::unique_lock<std::mutex> scope_lock(lock);
+                return ready_cv.wait_for(scope_lock, duration, [this]() { return ready; });
+            }
+
+            /* Run the callback once the result is set, immediately (on the calling thread) if it already is.
+             * @callback Callable run exactly once, should be short and must not throw.
+             */
+            void on_ready(task callback)
+            {
+                {
+                    std::lock_guard<std::mutex> scope_lock(lock);
+                    if (!ready)
+                    {
+                        callbacks.push_back(std::move(callback));
+                        return;
+                    }
+                }
+                callback();
+            }
+
+            void set_exception(std::exception_ptr e)
+            {
+                std::unique_lock<std::mutex> scope_lock(lock);
+                check_unsatisfied();
+                error = e;
+                complete(scope_lock);
+            }
+        };
+
+        // State shared by a <promise> and a <future> holding a value of type T.
+        template<typename T>
+        class shared_state : public shared_state_base
+        {
+        protected:
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            bool has_value = false;
+
+            T &value() { return *reinterpret_cast<T *>(&storage); }
+
+        public:
+            shared_state(std::shared_ptr<executor_handle> exec) : shared_state_base(std::move(exec)) { }
+
+            ~shared_state()
+            {
+                if (has_value)
+                    value().~T();
+            }
+
+            template<typename... Args>
+            void set_value(Args &&... args)
+            {
+                std::unique_lock<std::mutex> scope_lock(lock);
+                check_unsatisfied();
+                ::new(static_cast<void *>(&storage)) T(std::forward<Args>(args)...);
+                has_value = true;
+                complete(scope_lock);
+            }
+
+            // Wait for the result and move it out, or rethrow the stored exception.
+            T take()
+            {
+                wait();
+                if (error)
+                    std::rethrow_exception(error);
+                return std::move(value());
+            }
+        };
+
+        template<>
+        class shared_state<void> : public shared_state_base
+        {
+        public:
+            shared_state(std::shared_ptr<executor_handle> exec) : shared_state_base(std::move(exec)) { }
+
+            void set_value()
+            {
+                std::unique_lock<std::mutex> scope_lock(lock);
+                check_unsatisfied();
+                complete(scope_lock);
+            }
+
+            void take()
+            {
+                wait();
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        };
+
+        // Fulfil the promise with the result of fn(), or the exception it throws.
+        template<typename R>
+        struct fulfil
+        {
+            template<typename Fn>
+            static void run(promise<R> &p, Fn &&fn)
+            {
+                try
+                {
+                    p.set_value(fn());
+                }
+                catch (...)
+                {
+                    p.set_exception(std::current_exception());
+                }
+            }
+        };
+
+        template<>
+        struct fulfil<void>
+        {
+            // The promise type is deduced, as promise<void> is still incomplete here.
+            template<typename Fn, typename Promise>
+            static void run(Promise &p, Fn &&fn)
+            {
+                try
+                {
+                    fn();
+                }
+                catch (...)
+                {
+                    p.set_exception(std::current_exception());
+                    return;
+                }
+                p.set_value();
+            }
+        };
+
+        // Call fn with the value of the (ready) state, or without arguments if the state holds no value.
+        template<typename T>
+        struct call_with_result
+        {
+            template<typename Fn>
+            static auto run(Fn &fn, shared_state<T> &state) -> decltype(fn(state.take()))
+            {
+                return fn(state.take());
+            }
+        };
+
+        template<>
+        struct call_with_result<void>
+        {
+            template<typename Fn>
+            static auto run(Fn &fn, shared_state<void> &state) -> decltype(fn())
+            {
+                state.take();
+                return fn();
+            }
+        };
+
+        // Result type of a continuation Fn called on a future<T>.
+        template<typename T, typename Fn>
+        struct continuation_result
+        {
+            typedef typename std::result_of<Fn(T)>::type type;
+        };
+
+        template<typename Fn>
+        struct continuation_result<void, Fn>
+        {
+            typedef typename std::result_of<Fn()>::type type;
+        };
+
+        // Task running a continuation of a ready state, and fulfilling the promise of the next stage.
+        template<typename T, typename R, typename Fn>
+        struct continuation
+        {
+            std::shared_ptr<shared_state<T>> antecedent;
+            promise<R> next;
+            Fn fn;
+
+            void operator()()
+            {
+                fulfil<R>::run(next, [this]() -> R { return call_with_result<T>::run(fn, *antecedent); });
+            }
+        };
+
+        // Callback handing the task over to the executor, or running it in place if there is none (any more).
+        template<typename Fn>
+        struct schedule
+        {
+            std::shared_ptr<executor_handle> exec;
+            Fn fn;
+
+            void operator()()
+            {
+                if (exec)
+                {
+                    task t(std::move(fn));
+                    if (!exec->execute(t))
+                        t();
+                }
+                else
+                    fn();
+            }
+        };
+
+        template<typename T>
+        struct when_all_state;
+
+        template<typename T>
+        struct when_any_state;
+    }
+
+    /* The result of <when_any>: all the input futures, and the index of the first one that became ready. */
+    template<typename T>
+    struct when_any_result
+    {
+        size_t index;
+        std::vector<future<T>> futures;
+    };
+
+    /* Provider of a result (or an exception) for the associated <future>, similar to std::promise.
+     * @T Type of the result (may be void, can't be a reference).
+     *
+     * The shared state is allocated with <pool_allocator>. If the promise is destroyed without setting the result,
+     * the future receives std::future_error with broken_promise.
+     */
+    template<typename T>
+    class promise
+    {
+    protected:
+        std::shared_ptr<helper::shared_state<T>> state;
+        bool future_retrieved = false;
+
+    public:
+        /* Create a promise with a new shared state.
+         * @exec Handle of the executor used to run the continuations attached with <future::then>, nullptr to run
+         *  them in place.
+         */
+        explicit promise(std::shared_ptr<executor_handle> exec = nullptr) :
+                state(std::allocate_shared<helper::shared_state<T>>(pool_allocator<helper::shared_state<T>>(), exec)) { }
+
+        // Copy constructor, deleted.
+        promise(const promise &) = delete;
+
+        // Move constructor.
+        promise(promise &&other) = default;
+
+        // Move assignment.
+        promise &operator=(promise &&other)
+        {
+            abandon();
+            state = std::move(other.state);
+            future_retrieved = other.future_retrieved;
+            return *this;
+        }
+
+        // Destructor, breaks the promise if the result has not been set.
+        ~promise() { abandon(); }
+
+        /* Return the future associated with the promise, can only be called once.
+         *
+         * @return The future sharing the state with this promise.
+         */
+        future<T> get_future()
+        {
+            if (future_retrieved)
+                throw std::future_error(std::future_errc::future_already_retrieved);
+            future_retrieved = true;
+            return future<T>(state);
+        }
+
+        /* Store the result, making the future ready and scheduling its continuations.
+         * @args Arguments forwarded to the constructor of T (none if T is void).
+         */
+        template<typename... Args>
+        void set_value(Args &&... args) { state->set_value(std::forward<Args>(args)...); }
+
+        /* Store the exception, making the future ready and scheduling its continuations.
+         * @e Pointer to the exception.
+         */
+        void set_exception(std::exception_ptr e) { state->set_exception(e); }
+
+    private:
+        void abandon()
+        {
+            if (state && !state->is_ready())
+                state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    };
+
+    /* Result of an asynchronous operation, similar to std::future, which additionally supports continuations.
+     * @T Type of the result (may be void, can't be a reference).
+     *
+     * Continuations attached with <then> are run on the executor of the promise (e.g. the <thread_pool> which
+     * created the future with <async>) once the result is set, so that building pipelines doesn't block any thread.
+     * See also <when_all> and <when_any>.
+     */
+    template<typename T>
+    class future
+    {
+    protected:
+        std::shared_ptr<helper::shared_state<T>> state;
+
+        explicit future(std::shared_ptr<helper::shared_state<T>> state) : state(std::move(state)) { }
+
+        friend class promise<T>;
+
+        template<typename U>
+        friend class future;
+
+        template<typename U>
+        friend struct helper::when_all_state;
+
+        template<typename U>
+        friend struct helper::when_any_state;
+
+    public:
+        // Type of the result.
+        typedef T value_type;
+
+        // Create an invalid future, without a shared state.
+        future() { }
+
+        // Copy constructor, deleted.
+        future(const future &) = delete;
+
+        // Move constructor.
+        future(future &&other) = default;
+
+        // Move assignment.
+        future &operator=(future &&other) = default;
+
+        /* Checks whether the future has a shared state, i.e. it has been obtained from a promise and neither <get>
+         * nor <then> has been called yet.
+         */
+        bool valid() const { return state != nullptr; }
+
+        // Checks whether the result (or an exception) is available.
+        bool is_ready() const { return state->is_ready(); }
+
+        // Block until the result is available.
+        void wait() const { state->wait(); }
+
+        /* Block until the result is available or the duration passes.
+         * @duration Maximum time to wait.
+         *
+         * @return true if the result is available.
+         */
+        template<typename Rep, typename Period>
+        bool wait_for(const std::chrono::duration<Rep, Period> &duration) const { return state->wait_for(duration); }
+
+        /* Wait for the result and return it, or rethrow the exception. Invalidates the future.
+         *
+         * @return The result.
+         */
+        T get()
+        {
+            std::shared_ptr<helper::shared_state<T>> local(std::move(state));
+            return local->take();
+        }
+
+        /* Attach a continuation, run on the executor once the result is available. Invalidates the future.
+         * @fn Function called with the result (or without arguments, if T is void).
+         *
+         * If this future holds an exception, fn is not called and the exception is passed on to the returned future.
+         *
+         * @return Future holding the result of fn.
+         */
+        template<typename Fn, typename R = typename helper::continuation_result<T, Fn>::type>
+        future<R> then(Fn fn)
+        {
+            std::shared_ptr<helper::shared_state<T>> antecedent(std::move(state));
+            std::shared_ptr<executor_handle> exec = antecedent->exec;
+            promise<R> next(exec);
+            future<R> result = next.get_future();
+            helper::continuation<T, R, Fn> call{antecedent, std::move(next), std::move(fn)};
+            antecedent->on_ready(helper::schedule<helper::continuation<T, R, Fn>>{exec, std::move(call)});
+            return result;
+        }
+
+        /* Awaiter interface, so that a coroutine (see coroutine.hpp) can co_await the future: the coroutine is
+         * suspended until the result is available, and resumed on the executor (like the continuations of <then>).
+         * co_await evaluates to the result, or rethrows the exception. Invalidates the future.
+         */
+        bool await_ready() const { return is_ready(); }
+
+        // See <await_ready>.
+        template<typename Handle>
+        void await_suspend(Handle handle)
+        {
+            std::shared_ptr<executor_handle> exec = state->exec;
+            state->on_ready(helper::schedule<helper::resume_call<Handle>>{exec, helper::resume_call<Handle>(handle)});
+        }
+
+        // See <await_ready>.
+        T await_resume() { return get(); }
+    };
+
+    namespace helper
+    {
+        template<typename T>
+        struct when_all_state
+        {
+            typedef typename std::conditional<std::is_void<T>::value, void, std::vector<T>>::type result_type;
+
+            std::vector<future<T>> inputs;
+            promise<result_type> output;
+            std::atomic<size_t> remaining;
+            // Pass on all the exceptions as an exception_list, instead of the first one.
+            bool aggregate;
+
+            when_all_state(std::vector<future<T>> &&inputs, std::shared_ptr<executor_handle> exec, bool aggregate) :
+                    inputs(std::move(inputs)), output(exec), remaining(this->inputs.size()), aggregate(aggregate) { }
+
+            // Collect the results, once all the inputs are ready.
+            void arrive()
+            {
+                if (remaining.fetch_sub(1) != 1)
+                    return;
+                fulfil<result_type>::run(output, [this]() { return collect(); });
+            }
+
+            template<typename U = T>
+            typename std::enable_if<!std::is_void<U>::value, std::vector<T>>::type collect()
+            {
+                std::vector<T> results;
+                results.reserve(inputs.size());
+                exception_list errors;
+                for (auto &input : inputs)
+                {
+                    if (!aggregate)
+                    {
+                        results.push_back(input.get());
+                        continue;
+                    }
+                    try
+                    {
+                        results.push_back(input.get());
+                    }
+                    catch (...)
+                    {
+                        errors.push_back(std::current_exception());
+                    }
+                }
+                if (!errors.empty())
+                    throw errors;
+                return results;
+            }
+
+            template<typename U = T>
+            typename std::enable_if<std::is_void<U>::value>::type collect()
+            {
+                exception_list errors;
+                for (auto &input : inputs)
+                {
+                    if (!aggregate)
+                    {
+                        input.get();
+                        continue;
+                    }
+                    try
+                    {
+                        input.get();
+                    }
+                    catch (...)
+                    {
+                        errors.push_back(std::current_exception());
+                    }
+                }
+                if (!errors.empty())
+                    throw errors;
+            }
+
+            static future<result_type> start(std::vector<future<T>> &&inputs, bool aggregate)
+            {
+                std::shared_ptr<executor_handle> exec;
+                if (!inputs.empty())
+                    exec = inputs.front().state->exec;
+                auto all = std::allocate_shared<when_all_state<T>>(pool_allocator<when_all_state<T>>(),
+                                                                   std::move(inputs), exec, aggregate);
+                future<result_type> result = all->output.get_future();
+                if (all->inputs.empty())
+                {
+                    fulfil<result_type>::run(all->output, [&all]() { return all->collect(); });
+                    return result;
+                }
+                for (auto &input : all->inputs)
+                    input.state->on_ready([all]() { all->arrive(); });
+                return result;
+            }
+        };
+
+        template<typename T>
+        struct when_any_state
+        {
+            std::vector<future<T>> inputs;
+            promise<when_any_result<T>> output;
+            std::atomic_flag done = ATOMIC_FLAG_INIT;
+
+            when_any_state(std::vector<future<T>> &&inputs, std::shared_ptr<executor_handle> exec) :
+                    inputs(std::move(inputs)), output(exec) { }
+
+            // Hand all the inputs over to the result, once the first one is ready.
+            void arrive(size_t index)
+            {
+                if (done.test_and_set())
+                    return;
+                output.set_value(when_any_result<T>{index, std::move(inputs)});
+            }
+
+            static future<when_any_result<T>> start(std::vector<future<T>> &&inputs)
+            {
+                std::shared_ptr<executor_handle> exec;
+                if (!inputs.empty())
+                    exec = inputs.front().state->exec;
+                auto any = std::allocate_shared<when_any_state<T>>(pool_allocator<when_any_state<T>>(),
+                                                                   std::move(inputs), exec);
+                future<when_any_result<T>> result = any->output.get_future();
+                if (any->inputs.empty())
+                {
+                    any->arrive(0);
+                    return result;
+                }
+                // The first callback may move the inputs away, so the states are collected beforehand
+                std::vector<std::shared_ptr<shared_state<T>>> states;
+                for (auto &input : any->inputs)
+                    states.push_back(input.state);
+                for (size_t i = 0; i < states.size(); ++i)
+                    states[i]->on_ready([any, i]() { any->arrive(i); });
+                return result;
+            }
+        };
+    }
+
+    /* Create a future, which becomes ready once all the input futures are.
+     * @futures The input futures, moved into the shared state.
+     *
+     * @return future holding the vector of results (in the order of inputs), or future<void> for void inputs.
+     * If any of the inputs holds an exception, the first such exception (in the order of inputs) is passed on.
+     */
+    template<typename T>
+    future<typename helper::when_all_state<T>::result_type> when_all(std::vector<future<T>> futures)
+    {
+        return helper::when_all_state<T>::start(std::move(futures), false);
+    }
+
+    /* Create a future, which becomes ready once all the input futures are, collecting all of their exceptions.
+     * @futures The input futures, moved into the shared state.
+     *
+     * Same as <when_all>, except that if any of the inputs hold exceptions, all of them (in the order of inputs)
+     * are passed on as an <exception_list>.
+     */
+    template<typename T>
+    future<typename helper::when_all_state<T>::result_type> when_all_aggregate(std::vector<future<T>> futures)
+    {
+        return helper::when_all_state<T>::start(std::move(futures), true);
+    }
+
+    /* Create a future, which becomes ready once any of the input futures is.
+     * @futures The input futures, moved into the shared state.
+     *
+     * @return future holding <when_any_result> with the index of the first ready future and all the input futures.
+     */
+    template<typename T>
+    future<when_any_result<T>> when_any(std::vector<future<T>> futures)
+    {
+        return helper::when_any_state<T>::start(std::move(futures));
+    }
+}
+
+#endif //MDLUTILS_MULTITHREADING_FUTURE_HPP
@@ -6,12 +6,20 @@
 #define MDLUTILS_MULTITHREADING_HANDLER_HPP
 
 #include <queue>
+#include <vector>
+#include <functional>
 
 #include <mdlutils/exceptions/exception_handler.hpp>
+#include <mdlutils/multithreading/helpers.hpp>
+#include <mdlutils/memory/pool_allocator.hpp>
 #include <mdlutils/multithreading/messages.hpp>
+#include <mdlutils/multithreading/mpsc_queue.hpp>
 
 namespace mdl
 {
+    /* Message queue used by the <looper>s, with nodes allocated from the thread-cached block pool. */
+    typedef mpsc_queue<message_ptr, pool_allocator<message_ptr>> message_queue_type;
+
     /* Base class for message handlers.
      *
      * All message handlers should public-extend this class */
@@ -24,25 +32,60 @@ namespace mdl
          * @return true if the message has been completely processed by the handler, false otherwise.
          */
         virtual bool handle_message(message_ptr) = 0;
+
+        /* Checks whether the handler is interested in messages of a given type.
+         * @type Type tag of the message (see <message_type_id>).
+         *
+         * Loopers only pass the messages to the handlers accepting their type. By default all messages are accepted.
+         *
+         * @return true if messages of the given type should be passed to <handle_message>, false otherwise.
+         */
+        virtual bool accepts(message_type /*type*/) const { return true; }
     };
 
     /* Message handler automatically processing delayed_message messages.
      *
-     * Requires access to message queue and it's mutex
+     * Requires access to the message queue of the looper it's running on. Messages, which are not due yet, are kept
+     * in a min-heap keyed on their deadlines (messages with equal deadlines keep their order), and put into the queue
+     * by <release_due>, which the looper calls before waiting for new messages.
      */
     class delaying_handler : public handler
     {
     protected:
-        std::queue<message_ptr>& queue;
-        std::mutex& queue_lock;
+        // Pending delayed message.
+        struct timer
+        {
+            time_point_t deadline;
+            unsigned long long sequence;
+            message_ptr content;
+
+            bool operator>(const timer &other) const
+            {
+                return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+            }
+        };
+
+        message_queue_type& queue;
+        std::priority_queue<timer, std::vector<timer>, std::greater<timer>> timers;
+        unsigned long long next_sequence = 0;
     public:
-        /* Construct delaying_handler for the given message queue and mutex
+        /* Construct delaying_handler for the given message queue
          * @queue message queue, where delayed messages will be placed
-         * @lock std::mutex of the message queue.
          */
-        delaying_handler(std::queue<message_ptr>& queue, std::mutex& lock) : queue(queue), queue_lock(lock) { }
+        delaying_handler(message_queue_type& queue) : queue(queue) { }
         // @inherit
         virtual bool handle_message(message_ptr);
+
+        /* Put the messages, which are due, into the message queue. Has to be called from the looper thread.
+         *
+         * @return The deadline of the earliest message still pending, or time_point_t::max() if there are none.
+         */
+        time_point_t release_due();
+
+        // Number of messages still waiting for their deadlines.
+        size_t pending() const { return timers.size(); }
+        // @inherit
+        virtual bool accepts(message_type type) const { return type == message_type_id<delayed_message>(); }
     };
 
     /* Message handler automatically processing post_call messages.
@@ -54,6 +97,8 @@ namespace mdl
     public:
         // @inherit
         virtual bool handle_message(message_ptr);
+        // @inherit
+        virtual bool accepts(message_type type) const { return type == message_type_id<post_call>(); }
     };
 
     /* Message handler automatically processing break_message messages.
@@ -65,6 +110,8 @@ namespace mdl
     public:
         // @inherit
         virtual bool handle_message(message_ptr);
+        // @inherit
+        virtual bool accepts(message_type type) const { return type == message_type_id<break_message>(); }
     };
 }
 
@@ -17,6 +17,9 @@ namespace mdl
 
     namespace helper
     {
+        // Assumed size of a cache line, used to pad data written by different threads.
+        const size_t cache_line_size = 64;
+
         unsigned inline hw_concurrency()
         {
             return std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
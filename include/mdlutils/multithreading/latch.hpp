@@ -0,0 +1,61 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_LATCH_HPP
+#define MDLUTILS_MULTITHREADING_LATCH_HPP
+
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+
+namespace mdl
+{
+    /* Single-use downward counter, which threads can block on until it reaches zero (after std::latch from C++20).
+     *
+     * Counting down is a single atomic operation; the mutex is only touched by the thread reaching zero and
+     * by the waiting threads.
+     */
+    class latch
+    {
+    protected:
+        std::atomic<ptrdiff_t> counter;
+        std::mutex lock;
+        std::condition_variable released;
+
+    public:
+        /* Create a latch.
+         * @expected The initial value of the counter, can't be negative.
+         */
+        explicit latch(ptrdiff_t expected) : counter(expected) { }
+
+        // Copy constructor, deleted.
+        latch(const latch &) = delete;
+
+        /* Decrease the counter, releasing the waiting threads once it reaches zero.
+         * @n Value to subtract, can't be larger than the current value of the counter.
+         */
+        void count_down(ptrdiff_t n = 1);
+
+        /* Checks whether the counter has reached zero.
+         *
+         * @return true if the counter is zero.
+         */
+        bool try_wait() const { return counter.load(std::memory_order_acquire) == 0; }
+
+        // Block until the counter reaches zero.
+        void wait();
+
+        /* Decrease the counter and block until it reaches zero.
+         * @n Value to subtract.
+         */
+        void arrive_and_wait(ptrdiff_t n = 1)
+        {
+            count_down(n);
+            wait();
+        }
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_LATCH_HPP
@@ -9,16 +9,21 @@
 #include <memory>
 #include <atomic>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
 #include <list>
+#include <vector>
 
 #include <iostream>
 
 #include <mdlutils/accessor/getset_accessor.hpp>
 #include <mdlutils/exceptions/exception_handler.hpp>
 #include <mdlutils/exceptions/invalid_state_exception.hpp>
+#include <mdlutils/multithreading/awaitable.hpp>
+#include <mdlutils/multithreading/cancellation.hpp>
 #include <mdlutils/multithreading/handler.hpp>
 #include <mdlutils/multithreading/messages.hpp>
+#include <mdlutils/multithreading/metrics.hpp>
+#include <mdlutils/multithreading/priority.hpp>
 
 namespace mdl
 {
@@ -33,19 +38,72 @@ namespace mdl
         std::thread::id thread_id;
         std::thread &thread_ref;
 
-        // variable declared mutable to allow const size checks
-        mutable std::mutex message_queue_lock;
-        std::queue<message_ptr> message_queue;
+        // Lock-free queues of incoming messages, one per <priority>; the looper thread is the only consumer.
+        message_queue_type message_queues[priority_levels];
+        // Weighted selection between the queues.
+        helper::lane_scheduler lanes;
+        // Priority of the message being handled.
+        priority handled_priority = priority::normal;
+        // Break message put off until the messages queued before it (deferred_counts per queue) are handled.
+        message_ptr deferred_break;
+        size_t deferred_counts[priority_levels];
+
+        // Take the next message, according to the priorities. Returns false if all queues are empty.
+        bool pop_message(message_ptr &msg);
+
+        // Checks whether any of the queues has a message ready. May only be called by the looper thread.
+        bool message_ready() const;
+
+        // Wake the looper thread up, if it's parked waiting for messages.
+        void notify_looper()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (is_parked.load())
+            {
+                // Taking the lock guarantees that the looper is either already waiting, or yet to check the queue
+                { mutex_lock scope_lock(park_lock); }
+                message_queue_cv.notify_one();
+            }
+        }
+
+        // Scheduling counters, written by the looper thread only.
+        helper::scheduler_counters counters;
+
+        // Mutex and condition variable used to park the looper thread while the message queue is empty.
+        std::mutex park_lock;
+        std::condition_variable message_queue_cv;
+        // Set by <wake()>, cleared once <wait_for_message()> returns.
+        std::atomic_bool wake_pending{false};
+        // Number of times the looper yields before parking on message_queue_cv.
+        std::atomic<unsigned> spin_threshold{64};
 
         std::atomic_bool is_started{false};
         std::atomic_bool is_running{false};
         std::atomic_bool is_processing{false};
         std::atomic_bool is_stopped{false};
+        std::atomic_bool is_parked{false};
+        // Mutex and condition variable used to notify about the changes of is_started and is_stopped.
+        std::mutex state_lock;
+        std::condition_variable state_cv;
 
         std::list<std::reference_wrapper<mdl::handler>> handler_stack;
 
+        /* Jump table indexed by <message_type>, holding the handlers (in handler_stack order) accepting given type.
+         * Built lazily by the looper thread and extended, whenever a message with an unknown type shows up.
+         */
+        std::vector<std::vector<mdl::handler *>> dispatch_table;
+
+        // Rebuild dispatch_table to cover all message types up to (and including) max_type.
+        void build_dispatch_table(message_type max_type);
+
         void sequential_handle_message(message_ptr);
 
+        /* Hook for timers, called by <wait_for_message()> on the looper thread before it waits for messages.
+         *
+         * @return The time point at which the looper should wake up by itself, time_point_t::max() by default.
+         */
+        virtual time_point_t process_timers() { return time_point_t::max(); }
+
         mdl::exception_handler *exception_handler;
 
     private:
@@ -86,12 +144,14 @@ namespace mdl
         /* Virtual destructor. Sends stop signal to the loop, waits until it's done and calls join if the thread
          * is joinable.
          *
-         * Warning: may cause infinite loop, if looper is initialized, but loop() method has not been called.
+         * Warning: may cause infinite loop, if looper is initialized, and the thread is started, but loop() method
+         * is never called.
          */
         virtual ~looper_base()
         {
             //std::cout << "Destroying looper_base" << std::endl;
-            stop_and_join();
+            if (thread_ref.joinable() || running)
+                stop_and_join();
         }
 
         /* Main function of the looper. Once called, the looper will enter an infinite loop, until stopped by either calling
@@ -116,9 +176,17 @@ namespace mdl
         /* Blocks, until looper's started flag is set to true */
         void wait_until_started();
 
-        /* Blocks, until looper's stopped flag is set to true */
+        /* Blocks, until looper's stopped flag is set to true, and joins the thread, if it's joinable */
         void wait_until_finished();
 
+        /* Blocks, until looper's stopped flag is set to true or the deadline passes, and joins the thread, if it's
+         * joinable and finished.
+         * @deadline Time point after which to give up.
+         *
+         * @return true if the loop has finished.
+         */
+        bool wait_until_finished(time_point_t deadline);
+
         /* Evaluates to true, if the looper thread is currently running */
         mdl::get_accessor<bool> running = {
                 [&]()
@@ -143,32 +211,103 @@ namespace mdl
                     },
         };
 
+        /* Number of times the idle looper yields (checking for new messages in between) before it parks the
+         * thread until a message arrives. Higher values trade CPU time for lower wake up latency.
+         */
+        mdl::getset_accessor<unsigned> idle_spins = {
+                [&]()
+                    {
+                        return spin_threshold.load();
+                    },
+                [&](const unsigned &value)
+                    {
+                        spin_threshold.store(value);
+                    }
+        };
+
         /* Put the message into the message queue of the looper
          * @msg Shared pointer pointing to the message
+         * @p Priority of the message. Messages of the same priority are handled in FIFO order, while the more
+         *  urgent ones are handled first (see <helper::lane_scheduler>).
+         */
+        void send_message(message_ptr msg, priority p = priority::normal)
+        {
+            message_queues[helper::lane_of(p)].push(std::move(msg));
+            notify_looper();
+        }
+
+        /* Put all messages of a range into the message queue of the looper at once
+         * @first Input iterator pointing to the first message_ptr (inkl.).
+         * @last Input iterator pointing to the last message_ptr (excl.).
+         * @p Priority of the messages (see <send_message>).
+         *
+         * The messages are enqueued with a single atomic exchange (see <mpsc_queue::push>), and the looper is
+         * woken up at most once.
          */
-        void send_message(message_ptr msg)
+        template<typename InputIterator>
+        void send_messages(InputIterator first, InputIterator last, priority p = priority::normal)
         {
-            mutex_lock scope_lock(message_queue_lock);
-            message_queue.push(msg);
+            if (message_queues[helper::lane_of(p)].push(first, last))
+                notify_looper();
         }
 
+        /* Blocks until there is a message in the queue, the looper is stopped, <wake()> is called, or the deadline
+         * returned by <process_timers()> (e.g. of the earliest delayed message) passes.
+         *
+         * Yields <idle_spins> times first, and then parks the thread on a condition variable.
+         * Should only be called from the looper thread (e.g. by handlers waiting for more work).
+         *
+         * @return true if there is a message in the queue, false otherwise.
+         */
+        bool wait_for_message();
+
+        /* Same as <wait_for_message()>, but gives up at the given deadline at the latest.
+         * @limit Time point after which to stop waiting.
+         *
+         * @return true if there is a message in the queue, false otherwise.
+         */
+        bool wait_for_message(time_point_t limit);
+
+        /* Wakes the looper thread up, if it's blocked in <wait_for_message()>, or makes the next call return
+         * immediately otherwise.
+         */
+        void wake();
+
         /* Counts the number of messages in the queue
+         *
+         * The value is approximate, as it's read without synchronizing with the producers and the looper thread.
          *
          * @return Number of messages in the underlying message queue
          */
         size_t count() const
         {
-            mutex_lock scope_lock(message_queue_lock);
-            return message_queue.size();
+            size_t result = 0;
+            for (const auto &queue : message_queues)
+                result += queue.size();
+            return result;
         }
 
+        /* Take a snapshot of the scheduling counters (messages and tasks handled, time spent in the handlers and
+         * idle, etc.). May be called from any thread; the values are read without synchronizing with the looper
+         * thread, so they may be slightly out of date.
+         *
+         * @return The counters accumulated since the looper has been created.
+         */
+        looper_metrics metrics() const { return counters.snapshot(); }
+
+        /* Priority of the message being handled. Only meaningful on the looper thread, e.g. for the handlers.
+         *
+         * @return The priority the message has been sent with.
+         */
+        priority current_priority() const { return handled_priority; }
+
         /* Checks whether the message queue is empty.
          *
          * Equivalent to !count().
          *
          * @return true if the message queue is empty, false otherwise.
          */
-        bool empty() { return !count(); }
+        bool empty() const { return !count(); }
     };
 
     /* Implementation of <looper_base>, implementing executor_handler and delaying_handler for processing
@@ -182,7 +321,7 @@ namespace mdl
         looper(std::thread &looper_thread, Handlers &... handlers) :
                 looper_base(looper_thread, static_cast<delaying_handler &>(*this),
                             static_cast<executor_handler &>(*this), handlers...),
-                delaying_handler(message_queue, message_queue_lock) { }
+                delaying_handler(message_queues[helper::lane_of(priority::normal)]) { }
 
         // @inherit
         virtual ~looper()
@@ -190,6 +329,12 @@ namespace mdl
             //std::cout << "Destroying looper" << std::endl;
         }
 
+    protected:
+        // Releases the delayed messages which are due, and sleeps until the next one.
+        virtual time_point_t process_timers() { return release_due(); }
+
+    public:
+
         /* Put message msg wrapped in delayed_message, to be run at a timestamp equal to
          * std::chrono::high_resolution_clock::now() + duration.
          * @msg Shared pointer to the message instance.
@@ -199,11 +344,10 @@ namespace mdl
          */
         void send_message_delayed(message_ptr msg, duration_t duration)
         {
-            mutex_lock scope_lock(message_queue_lock);
             if (duration <= duration_t::zero())
-                message_queue.push(msg);
+                send_message(msg);
             else
-                message_queue.push(
+                send_message(
                         std::make_shared<delayed_message>(
                                 msg, helper::delay_by(duration)
                         )
@@ -218,22 +362,22 @@ namespace mdl
          */
         void send_message_at_time(message_ptr msg, time_point_t run_at)
         {
-            mutex_lock scope_lock(message_queue_lock);
             if (helper::is_after(run_at))
-                message_queue.push(msg);
+                send_message(msg);
             else
-                message_queue.push(
+                send_message(
                         std::make_shared<delayed_message>(msg, run_at)
                 );
         }
 
         /* Wrap the function runnable inside a <post_call> message and enqueue it.
          * @runnable A function or callable convertible to std::function, with any return type and without arguments.
+         * @p Priority of the message (see <send_message>).
          */
         template<typename T>
-        void post(std::function<T(void)> runnable)
+        void post(std::function<T(void)> runnable, priority p = priority::normal)
         {
-            send_message(std::make_shared<post_call>(runnable));
+            send_message(std::make_shared<post_call>(runnable), p);
         }
 
         /* Combines <post> and <send_message_delayed>.
@@ -260,6 +404,75 @@ namespace mdl
         {
             send_message_at_time(std::make_shared<post_call>(runnable), run_at);
         }
+
+        /* Combines <post> and <send_message_delayed>, unless cancelled before the delay passes.
+         * @runnable A function or callable convertible to std::function, with any return type and without arguments.
+         * @duration Time in duration_t (equivalent to std::chrono::high_resolution_clock::duration)
+         * @token Token checked right before the runnable is called; if cancelled by then, the runnable is dropped.
+         *
+         * The runnable may also poll the token (captured by itself) to stop early once started.
+         */
+        template<typename T>
+        void post_delayed(std::function<T(void)> runnable, duration_t duration, cancellation_token token)
+        {
+            send_message_delayed(std::make_shared<post_call>(cancellable_runnable(std::move(runnable), std::move(token))),
+                                 duration);
+        }
+
+        /* Combines <post> and <send_message_at_time>, unless cancelled before run_at is reached.
+         * @runnable A function or callable convertible to std::function, with any return type and without arguments.
+         * @run_at Time after which the message should be requeued without the delayed_message wrapper.
+         * @token Token checked right before the runnable is called; if cancelled by then, the runnable is dropped.
+         */
+        template<typename T>
+        void post_at_time(std::function<T(void)> runnable, time_point_t run_at, cancellation_token token)
+        {
+            send_message_at_time(std::make_shared<post_call>(cancellable_runnable(std::move(runnable), std::move(token))),
+                                 run_at);
+        }
+
+        /* Awaiter returned by <schedule> and <schedule_after>, resuming the coroutine on the looper thread. */
+        struct resume_awaiter
+        {
+            looper &target;
+            time_point_t run_at;
+
+            bool await_ready() const { return false; }
+
+            template<typename Handle>
+            void await_suspend(Handle handle)
+            {
+                target.send_message_at_time(std::make_shared<post_call>(helper::resume_call<Handle>(handle)), run_at);
+            }
+
+            void await_resume() { }
+        };
+
+        /* co_await looper.schedule() suspends the coroutine (see coroutine.hpp) and resumes it on the looper thread.
+         *
+         * @return Awaiter, to be used with co_await.
+         */
+        resume_awaiter schedule() { return resume_awaiter{*this, time_point_t::min()}; }
+
+        /* co_await looper.schedule_after(duration) suspends the coroutine and resumes it on the looper thread once
+         * the duration passes (see <post_delayed>). No thread is blocked in the meantime.
+         * @duration Time in duration_t (equivalent to std::chrono::high_resolution_clock::duration)
+         *
+         * @return Awaiter, to be used with co_await.
+         */
+        resume_awaiter schedule_after(duration_t duration) { return resume_awaiter{*this, helper::delay_by(duration)}; }
+
+    protected:
+        // Wrap the runnable, so that it is skipped once the token is cancelled.
+        template<typename T>
+        static std::function<void(void)> cancellable_runnable(std::function<T(void)> runnable, cancellation_token token)
+        {
+            return [runnable, token]()
+                {
+                    if (!token.is_cancelled())
+                        runnable();
+                };
+        }
     };
 
     /* Implementation of <looper> associated with std::thread, which automatically invokes the loop() method at startup. */
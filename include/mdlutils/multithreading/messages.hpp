@@ -6,32 +6,80 @@
 #define MDLUTILS_MULTITHREADING_MESSAGES_HPP
 
 #include <memory>
+#include <atomic>
 #include <functional>
 
 #include <mdlutils/multithreading/helpers.hpp>
+#include <mdlutils/multithreading/task.hpp>
 
 namespace mdl
 {
+    /* Identifier of a message type, used by the <looper>s to dispatch messages only to the interested handlers.
+     *
+     * The value 0 is reserved for generic messages (and null messages), which are offered to every handler.
+     */
+    typedef unsigned message_type;
+
+    namespace helper
+    {
+        // Returns a new, unique <message_type> identifier.
+        message_type inline register_message_type()
+        {
+            static std::atomic<message_type> next_type{1};
+            return next_type++;
+        }
+    }
+
+    /* Returns the <message_type> identifier of the message class T.
+     *
+     * The identifiers are assigned at runtime, on the first call for a given type, and are unique within the program.
+     */
+    template<typename T>
+    message_type message_type_id()
+    {
+        static const message_type type = helper::register_message_type();
+        return type;
+    }
+
     /* Base structure for messages handled by the <looper>s. */
     struct message
     {
+        // Generic message, offered to all handlers.
+        message() : type(0) { }
+
         virtual ~message() { }
+
+        // Type tag of the message, see <message_type_id>.
+        const message_type type;
+
+    protected:
+        /* Create a message with a given type tag.
+         * @type Type tag, usually message_type_id<Derived>().
+         */
+        message(message_type type) : type(type) { }
     };
 
+    template<>
+    inline message_type message_type_id<message>() { return 0; }
+
     /* Message used to force loopers to break out their loops. */
     struct break_message : public message
-    { virtual ~break_message() {} };
+    {
+        break_message() : message(message_type_id<break_message>()) { }
+
+        virtual ~break_message() {}
+    };
 
     /* Message used by <executor_handler> et.al. to call functions passed along with the message. */
     struct post_call : public message
     {
-        /* Create a post_call message for a given function. */
-        post_call(std::function<void(void)> &&function) : function(std::move(function)) { }
+        /* Create a post_call message for a given function (any callable, see <task>). */
+        post_call(task &&function) : message(message_type_id<post_call>()), function(std::move(function)) { }
 
         virtual ~post_call() { }
     
         // The function carried along with the message.
-        std::function<void(void)> function;
+        task function;
     };
 
     /* Message used by <delaying_handler> et.al. to requeue the enveloped messages until a time point is reached. */
@@ -42,7 +90,8 @@ namespace mdl
          * @delayed_until A time point after which the message will be requeued without the envelope.
          */
         delayed_message(std::shared_ptr<message> content,
-                        time_point_t delayed_until) : content(content), delayed_until(delayed_until) { }
+                        time_point_t delayed_until) : message(message_type_id<delayed_message>()),
+                                                      content(content), delayed_until(delayed_until) { }
 
         virtual ~delayed_message() { }
 
@@ -54,6 +103,17 @@ namespace mdl
 
     /* Shared pointer to the message type. All message queues and handlers should use this type. */
     typedef std::shared_ptr<message> message_ptr;
+
+    /* Returns true, if msg is a non-null message with the type tag of T.
+     * @msg Message to check.
+     *
+     * Allows to static_cast the message to T, in place of a dynamic_pointer_cast.
+     */
+    template<typename T>
+    bool is_message(const message_ptr &msg)
+    {
+        return msg != nullptr && msg->type == message_type_id<T>();
+    }
 }
 
 #endif //MDLUTILS_MULTITHREADING_MESSAGES_HPP
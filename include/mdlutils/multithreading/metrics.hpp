@@ -0,0 +1,175 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_METRICS_HPP
+#define MDLUTILS_MULTITHREADING_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <mdlutils/typedefs.hpp>
+
+namespace mdl
+{
+    /* Snapshot of the scheduling counters of a single looper (e.g. a <thread_pool> worker).
+     *
+     * All values are cumulative since the looper has been created.
+     */
+    struct looper_metrics
+    {
+        // Number of buckets of <task_times>.
+        static const size_t histogram_buckets = 32;
+
+        // Messages handled by the loop.
+        uint64_t messages_handled = 0;
+        // Tasks (post_call messages and thread_pool tasks) executed.
+        uint64_t tasks_executed = 0;
+        // The largest number of messages (or, under work_stealing, deque entries) seen waiting at once.
+        size_t queue_high_water = 0;
+        // Time spent in the handlers, excluding the time they spent waiting for messages.
+        duration_t handler_time = duration_t::zero();
+        // Time spent waiting for messages, spinning or parked.
+        duration_t idle_time = duration_t::zero();
+        // Number of times the parked thread has been woken up.
+        uint64_t wakeups = 0;
+        // Tasks stolen from other workers (work_stealing only).
+        uint64_t steals = 0;
+        // Histogram of task run times; bucket i counts the tasks that took [2^i, 2^(i+1)) nanoseconds, the first
+        // and the last bucket also count the shorter and the longer ones, respectively.
+        std::array<uint64_t, histogram_buckets> task_times{};
+
+        // Accumulate the counters of another looper; the high-water mark is the maximum of both.
+        looper_metrics &operator+=(const looper_metrics &other);
+    };
+
+    /* Snapshot of the scheduling counters of a <thread_pool>. */
+    struct thread_pool_metrics
+    {
+        // Counters of each of the workers, indexed by the worker id.
+        std::vector<looper_metrics> workers;
+        // The largest number of tasks seen waiting at once in the shared queues (dynamic only).
+        size_t shared_queue_high_water = 0;
+
+        // Sum of the counters of all workers.
+        looper_metrics total() const;
+    };
+
+    namespace helper
+    {
+        /* Scheduling counters of a looper, written only by the looper thread (with relaxed atomics, so that
+         * <snapshot> may be taken from any thread without locking).
+         *
+         * The looper thread registers its counters with <attach>, so that the code running tasks on it (e.g.
+         * <executor_handler> or <thread_pool>) can find them with <current>.
+         */
+        class scheduler_counters
+        {
+        protected:
+            std::atomic<uint64_t> messages{0};
+            std::atomic<uint64_t> tasks{0};
+            std::atomic<size_t> high_water{0};
+            std::atomic<int64_t> handler_ns{0};
+            std::atomic<int64_t> idle_ns{0};
+            std::atomic<uint64_t> wakeups{0};
+            std::atomic<uint64_t> steals{0};
+            std::atomic<uint64_t> task_times[looper_metrics::histogram_buckets];
+
+            static thread_local scheduler_counters *current_counters;
+
+            // Single writer, so a plain load and store is enough.
+            template<typename T, typename U>
+            static void add(std::atomic<T> &counter, U value)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+
+            static int64_t nanoseconds(duration_t duration)
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            }
+
+        public:
+            scheduler_counters()
+            {
+                for (auto &bucket : task_times)
+                    bucket.store(0, std::memory_order_relaxed);
+            }
+
+            // Copy constructor, deleted.
+            scheduler_counters(const scheduler_counters &) = delete;
+
+            // Counters of the looper running on the current thread, or nullptr.
+            static scheduler_counters *current() { return current_counters; }
+
+            /* Register the counters as the ones of the current thread.
+             * @counters Counters to register, or nullptr to detach.
+             */
+            static void attach(scheduler_counters *counters) { current_counters = counters; }
+
+            // Index of the <looper_metrics::task_times> bucket for the duration.
+            static size_t bucket_of(duration_t duration);
+
+            void record_message(duration_t duration)
+            {
+                add(messages, 1);
+                add(handler_ns, nanoseconds(duration));
+            }
+
+            void record_task(duration_t duration)
+            {
+                add(tasks, 1);
+                add(task_times[bucket_of(duration)], 1);
+            }
+
+            void record_idle(duration_t duration) { add(idle_ns, nanoseconds(duration)); }
+
+            void record_wakeup() { add(wakeups, 1); }
+
+            void record_steal() { add(steals, 1); }
+
+            void record_depth(size_t depth)
+            {
+                if (depth > high_water.load(std::memory_order_relaxed))
+                    high_water.store(depth, std::memory_order_relaxed);
+            }
+
+            // Total idle time, used by the looper thread to exclude waits nested in handlers.
+            duration_t idle_time() const
+            {
+                return std::chrono::duration_cast<duration_t>(
+                        std::chrono::nanoseconds(idle_ns.load(std::memory_order_relaxed)));
+            }
+
+            // Read the counters. May be called from any thread, the values may be slightly out of date.
+            looper_metrics snapshot() const;
+        };
+
+        /* Scope guard recording the run time of a task in the counters of the current thread, if there are any. */
+        class task_timer
+        {
+            scheduler_counters *counters;
+            time_point_t start;
+
+        public:
+            task_timer() : counters(scheduler_counters::current())
+            {
+                if (counters)
+                    start = std::chrono::high_resolution_clock::now();
+            }
+
+            task_timer(const task_timer &) = delete;
+
+            ~task_timer()
+            {
+                if (counters)
+                    counters->record_task(std::chrono::high_resolution_clock::now() - start);
+            }
+        };
+    }
+}
+
+#endif //MDLUTILS_MULTITHREADING_METRICS_HPP
@@ -0,0 +1,190 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_MPSC_QUEUE_HPP
+#define MDLUTILS_MULTITHREADING_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace mdl
+{
+    /* Lock-free, unbounded, multi-producer/single-consumer FIFO queue.
+     * @T Type of the stored elements.
+     * @Alloc Type of the allocator object used to allocate the nodes of the queue.
+     *
+     * Based on Dmitry Vyukov's intrusive MPSC node-based queue: producers link their nodes with a single
+     * atomic exchange on the head, while the consumer follows the next pointers from the tail without
+     * any synchronization with other consumers. A stub node is kept at the tail at all times, so that
+     * push never has to touch the consumer side.
+     *
+     * Any thread may call <push>, only one thread at a time may call <pop> and <ready>.
+     */
+    template<typename T, typename Alloc = std::allocator<T>>
+    class mpsc_queue
+    {
+    protected:
+        // Node of the singly linked list, the value of the tail (stub) node is always empty.
+        struct node
+        {
+            std::atomic<node *> next{nullptr};
+            T value;
+
+            node() : value() { }
+
+            node(T &&value) : value(std::move(value)) { }
+        };
+
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<node> node_allocator_type;
+        typedef std::allocator_traits<node_allocator_type> node_traits;
+
+        // Allocator used for the nodes.
+        node_allocator_type node_alloc;
+        // The most recently pushed node, shared by all producers.
+        std::atomic<node *> head;
+        // The stub node preceding the next element to pop, owned by the consumer.
+        node *tail;
+        // Approximate number of elements, updated with relaxed ordering.
+        std::atomic<size_t> counter{0};
+
+        template<typename... Args>
+        node *make_node(Args &&... args)
+        {
+            node *n = node_traits::allocate(node_alloc, 1);
+            try
+            {
+                node_traits::construct(node_alloc, n, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                node_traits::deallocate(node_alloc, n, 1);
+                throw;
+            }
+            return n;
+        }
+
+        void destroy_node(node *n)
+        {
+            node_traits::destroy(node_alloc, n);
+            node_traits::deallocate(node_alloc, n, 1);
+        }
+
+    public:
+        /* Create an empty queue.
+         * @alloc Allocator object.
+         */
+        mpsc_queue(const Alloc &alloc = Alloc()) : node_alloc(alloc)
+        {
+            tail = make_node();
+            head.store(tail, std::memory_order_relaxed);
+        }
+
+        // Copy constructor, deleted.
+        mpsc_queue(const mpsc_queue<T, Alloc> &) = delete;
+
+        // Destructor, destroys all the remaining elements.
+        ~mpsc_queue()
+        {
+            while (tail != nullptr)
+            {
+                node *next = tail->next.load(std::memory_order_relaxed);
+                destroy_node(tail);
+                tail = next;
+            }
+        }
+
+        /* Enqueue an element. May be called by any thread.
+         * @value The element to enqueue.
+         */
+        void push(T value)
+        {
+            node *n = make_node(std::move(value));
+            counter.fetch_add(1, std::memory_order_relaxed);
+            node *prev = head.exchange(n, std::memory_order_acq_rel);
+            // Between the exchange and this store the queue is temporarily "cut", which the consumer sees as empty.
+            prev->next.store(n, std::memory_order_release);
+        }
+
+        /* Enqueue all elements of a range at once. May be called by any thread.
+         * @first Input iterator pointing to the first element to enqueue (inkl.).
+         * @last Input iterator pointing to the last element to enqueue (excl.).
+         *
+         * The nodes are linked into a chain first, and the whole chain is published with a single atomic exchange,
+         * so the elements stay contiguous in the queue, even with other producers pushing concurrently.
+         *
+         * @return Number of enqueued elements.
+         */
+        template<typename InputIterator>
+        size_t push(InputIterator first, InputIterator last)
+        {
+            if (first == last)
+                return 0;
+            node *chain_first = make_node(T(*first));
+            node *chain_last = chain_first;
+            size_t n = 1;
+            try
+            {
+                for (++first; first != last; ++first, ++n)
+                {
+                    node *link = make_node(T(*first));
+                    chain_last->next.store(link, std::memory_order_relaxed);
+                    chain_last = link;
+                }
+            }
+            catch (...)
+            {
+                while (chain_first != nullptr)
+                {
+                    node *next = chain_first->next.load(std::memory_order_relaxed);
+                    destroy_node(chain_first);
+                    chain_first = next;
+                }
+                throw;
+            }
+            counter.fetch_add(n, std::memory_order_relaxed);
+            node *prev = head.exchange(chain_last, std::memory_order_acq_rel);
+            prev->next.store(chain_first, std::memory_order_release);
+            return n;
+        }
+
+        /* Dequeue the oldest element. May only be called by the consumer.
+         * @value Set to the dequeued element on success.
+         *
+         * @return true if an element has been dequeued, false if the queue was (or appeared) empty.
+         */
+        bool pop(T &value)
+        {
+            node *next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            value = std::move(next->value);
+            next->value = T();
+            destroy_node(tail);
+            tail = next;
+            counter.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /* Checks whether the next <pop> will succeed. May only be called by the consumer.
+         *
+         * @return true if there is a fully enqueued element at the front of the queue.
+         */
+        bool ready() const { return tail->next.load(std::memory_order_acquire) != nullptr; }
+
+        /* Approximate the number of elements in the queue. May be called by any thread.
+         *
+         * @return Number of elements in the queue at some point during the call.
+         */
+        size_t size() const { return counter.load(std::memory_order_relaxed); }
+
+        /* Checks whether the queue is (approximately) empty. May be called by any thread.
+         *
+         * Equivalent to !size().
+         */
+        bool empty() const { return !size(); }
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_MPSC_QUEUE_HPP
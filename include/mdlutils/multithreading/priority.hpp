@@ -0,0 +1,84 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_PRIORITY_HPP
+#define MDLUTILS_MULTITHREADING_PRIORITY_HPP
+
+#include <cstddef>
+
+namespace mdl
+{
+    /* Priority classes of messages and tasks, from the most urgent one. */
+    enum class priority : unsigned
+    {
+        // Latency-sensitive work, taken before anything else.
+        critical,
+        // The default priority.
+        normal,
+        // Throughput-oriented batch work, taken when nothing more urgent is waiting (but never starved).
+        bulk
+    };
+
+    // Number of <priority> classes.
+    const size_t priority_levels = 3;
+
+    namespace helper
+    {
+        /* Weighted, starvation-free selection between per-priority lanes.
+         *
+         * Work is taken in rounds: within a round, each lane may give up to its weight of items, and the most urgent
+         * lane with items and remaining credit is always taken first. A new round starts once all non-empty lanes
+         * have used up their credit, so under full load the lanes get their weights' share (8:4:1) of the consumer,
+         * while an urgent item waits for at most a round's worth of less urgent ones.
+         */
+        class lane_scheduler
+        {
+        protected:
+            unsigned credits[priority_levels];
+
+            static unsigned weight(size_t lane)
+            {
+                static const unsigned weights[priority_levels] = {8, 4, 1};
+                return weights[lane];
+            }
+
+            void new_round()
+            {
+                for (size_t lane = 0; lane < priority_levels; ++lane)
+                    credits[lane] = weight(lane);
+            }
+
+        public:
+            lane_scheduler() { new_round(); }
+
+            /* Take the next item from the lanes.
+             * @try_take Callable try_take(size_t lane) -> bool, taking an item from the given lane if there is one.
+             *
+             * @return The lane the item has been taken from, or priority_levels if all lanes are empty.
+             */
+            template<typename TryTake>
+            size_t next(TryTake &&try_take)
+            {
+                for (int round = 0; round < 2; ++round)
+                {
+                    for (size_t lane = 0; lane < priority_levels; ++lane)
+                    {
+                        if (credits[lane] > 0 && try_take(lane))
+                        {
+                            --credits[lane];
+                            return lane;
+                        }
+                    }
+                    new_round();
+                }
+                return priority_levels;
+            }
+        };
+
+        // Index of the lane of the given priority.
+        inline size_t lane_of(priority p) { return static_cast<size_t>(p); }
+    }
+}
+
+#endif //MDLUTILS_MULTITHREADING_PRIORITY_HPP
@@ -0,0 +1,202 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_TASK_HPP
+#define MDLUTILS_MULTITHREADING_TASK_HPP
+
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+#include <mdlutils/memory/pool_allocator.hpp>
+
+namespace mdl
+{
+    /* Move-only, type-erased void() callable with small buffer optimization.
+     *
+     * Callables of up to <inline_size> bytes (with a non-throwing move constructor) are stored inside the task
+     * object itself, larger ones are allocated with <pool_allocator>. Unlike std::function, the stored callable
+     * does not have to be copyable, so it may hold e.g. a std::promise.
+     */
+    class task
+    {
+    public:
+        // Size of the inline storage; the whole task object spans a single cache line.
+        static const size_t inline_size = 56;
+
+    protected:
+        typedef std::aligned_storage<inline_size, alignof(void *)>::type storage_type;
+
+        // Type-specific operations on the stored callable.
+        struct operations
+        {
+            void (*invoke)(storage_type &);
+            void (*move)(storage_type &to, storage_type &from);
+            void (*destroy)(storage_type &);
+        };
+
+        template<typename Fn>
+        struct fits_inline
+        {
+            static const bool value = sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(storage_type) &&
+                                      std::is_nothrow_move_constructible<Fn>::value;
+        };
+
+        // Operations on a callable stored inline.
+        template<typename Fn>
+        struct inline_operations
+        {
+            static Fn &get(storage_type &storage) { return *reinterpret_cast<Fn *>(&storage); }
+
+            static void invoke(storage_type &storage) { get(storage)(); }
+
+            static void move(storage_type &to, storage_type &from)
+            {
+                ::new(static_cast<void *>(&to)) Fn(std::move(get(from)));
+                get(from).~Fn();
+            }
+
+            static void destroy(storage_type &storage) { get(storage).~Fn(); }
+
+            static const operations table;
+        };
+
+        // Operations on a callable allocated with <pool_allocator>, holding only the pointer inline.
+        template<typename Fn>
+        struct pooled_operations
+        {
+            static Fn *&get(storage_type &storage) { return *reinterpret_cast<Fn **>(&storage); }
+
+            static void invoke(storage_type &storage) { (*get(storage))(); }
+
+            static void move(storage_type &to, storage_type &from)
+            {
+                ::new(static_cast<void *>(&to)) Fn *(get(from));
+            }
+
+            static void destroy(storage_type &storage)
+            {
+                pool_allocator<Fn> alloc;
+                Fn *fn = get(storage);
+                fn->~Fn();
+                alloc.deallocate(fn, 1);
+            }
+
+            static const operations table;
+        };
+
+        const operations *ops;
+        storage_type storage;
+
+        template<typename Fn>
+        typename std::enable_if<fits_inline<Fn>::value>::type
+        store(Fn &&fn)
+        {
+            ::new(static_cast<void *>(&storage)) Fn(std::move(fn));
+            ops = &inline_operations<Fn>::table;
+        }
+
+        template<typename Fn>
+        typename std::enable_if<!fits_inline<Fn>::value>::type
+        store(Fn &&fn)
+        {
+            pool_allocator<Fn> alloc;
+            Fn *pointer = alloc.allocate(1);
+            try
+            {
+                ::new(static_cast<void *>(pointer)) Fn(std::move(fn));
+            }
+            catch (...)
+            {
+                alloc.deallocate(pointer, 1);
+                throw;
+            }
+            ::new(static_cast<void *>(&storage)) Fn *(pointer);
+            ops = &pooled_operations<Fn>::table;
+        }
+
+        void reset()
+        {
+            if (ops)
+                ops->destroy(storage);
+            ops = nullptr;
+        }
+
+    public:
+        // Create an empty task.
+        task() : ops(nullptr) { }
+
+        // Create an empty task.
+        task(std::nullptr_t) : ops(nullptr) { }
+
+        /* Create a task wrapping the given callable.
+         * @fn Callable invocable without arguments; the result, if any, is discarded.
+         */
+        template<typename Fn, typename = typename std::enable_if<
+                !std::is_same<typename std::decay<Fn>::type, task>::value>::type>
+        task(Fn &&fn) : ops(nullptr)
+        {
+            typename std::decay<Fn>::type local(std::forward<Fn>(fn));
+            store(std::move(local));
+        }
+
+        // Copy constructor, deleted.
+        task(const task &) = delete;
+
+        // Move constructor.
+        task(task &&other) : ops(other.ops)
+        {
+            if (ops)
+                ops->move(storage, other.storage);
+            other.ops = nullptr;
+        }
+
+        // Destroys the stored callable.
+        ~task() { reset(); }
+
+        // Move assignment.
+        task &operator=(task &&other)
+        {
+            if (this != &other)
+            {
+                reset();
+                ops = other.ops;
+                if (ops)
+                    ops->move(storage, other.storage);
+                other.ops = nullptr;
+            }
+            return *this;
+        }
+
+        // Destroys the stored callable, leaving the task empty.
+        task &operator=(std::nullptr_t)
+        {
+            reset();
+            return *this;
+        }
+
+        // Invoke the stored callable. Undefined behaviour if the task is empty.
+        void operator()() { ops->invoke(storage); }
+
+        // Evaluates to true, if the task holds a callable.
+        explicit operator bool() const { return ops != nullptr; }
+    };
+
+    template<typename Fn>
+    const task::operations task::inline_operations<Fn>::table = {
+            &task::inline_operations<Fn>::invoke,
+            &task::inline_operations<Fn>::move,
+            &task::inline_operations<Fn>::destroy
+    };
+
+    template<typename Fn>
+    const task::operations task::pooled_operations<Fn>::table = {
+            &task::pooled_operations<Fn>::invoke,
+            &task::pooled_operations<Fn>::move,
+            &task::pooled_operations<Fn>::destroy
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_TASK_HPP
@@ -6,7 +6,10 @@
 #define MDLUTILS_MULTITHREADING_THREAD_POOL_HPP
 
 #include <mutex>
+#include <condition_variable>
+#include <algorithm>
 #include <queue>
+#include <deque>
 #include <thread>
 #include <atomic>
 #include <future>
@@ -18,21 +21,197 @@
 #include <mdlutils/exceptions.hpp>
 #include <mdlutils/accessor/const_accessor.hpp>
 #include <mdlutils/types/const_vector.hpp>
+#include <mdlutils/types/range.hpp>
+#include <mdlutils/memory/pool_allocator.hpp>
+#include <mdlutils/multithreading/cancellation.hpp>
 #include <mdlutils/multithreading/helpers.hpp>
 #include <mdlutils/multithreading/handler.hpp>
 #include <mdlutils/multithreading/looper.hpp>
+#include <mdlutils/multithreading/metrics.hpp>
+#include <mdlutils/multithreading/latch.hpp>
+#include <mdlutils/multithreading/future.hpp>
+#include <mdlutils/multithreading/topology.hpp>
+#include <mdlutils/multithreading/priority.hpp>
+#include <mdlutils/multithreading/work_stealing_deque.hpp>
 
 namespace mdl
 {
+    namespace helper
+    {
+        /* Callable run by the tasks created with <thread_pool::async>, fulfilling the promise with the result of fn,
+         * or with the exception it throws.
+         * @T Result type.
+         * @Fn Type of the (bound) function.
+         */
+        template<typename T, typename Fn>
+        struct async_call
+        {
+            mdl::promise<T> promise;
+            Fn fn;
+
+            async_call(mdl::promise<T> &&promise, Fn &&fn) : promise(std::move(promise)), fn(std::move(fn)) { }
+
+            void operator()() { fulfil<T>::run(promise, fn); }
+        };
+
+        /* Variant of <async_call> checking a <cancellation_token> right before calling fn; if it has been cancelled
+         * while the task was queued, fn is skipped and the promise holds <operation_cancelled_exception>.
+         */
+        template<typename T, typename Fn>
+        struct cancellable_call
+        {
+            mdl::promise<T> promise;
+            cancellation_token token;
+            Fn fn;
+
+            cancellable_call(mdl::promise<T> &&promise, cancellation_token token, Fn &&fn) :
+                    promise(std::move(promise)), token(std::move(token)), fn(std::move(fn)) { }
+
+            void operator()()
+            {
+                fulfil<T>::run(promise, [this]() -> T
+                    {
+                        token.throw_if_cancelled();
+                        return fn();
+                    });
+            }
+        };
+
+        /* Shared state of a chunked loop (see <thread_pool::map>, <thread_pool::reduce> etc.); the index range
+         * [0, size) is split into <chunks> contiguous blocks, claimed one by one by the workers and the calling thread.
+         * @Body Type of the function called as body(chunk, begin, end) for each chunk.
+         */
+        template<typename Body>
+        struct chunked_loop
+        {
+            Body body;
+            size_t size;
+            size_t grain_size;
+            size_t chunks;
+            // Index of the next unclaimed chunk.
+            std::atomic<size_t> next_chunk{0};
+            // Counted down once per finished chunk.
+            latch done;
+            // The first exception thrown by the body.
+            std::exception_ptr error;
+            std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+
+            chunked_loop(Body body, size_t size, size_t grain_size) :
+                    body(std::move(body)), size(size), grain_size(grain_size),
+                    chunks((size + grain_size - 1) / grain_size), done(static_cast<ptrdiff_t>(chunks)) { }
+
+            // Claim and run chunks, until none are left.
+            void run()
+            {
+                size_t chunk;
+                while ((chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks)
+                {
+                    size_t begin = chunk * grain_size;
+                    try
+                    {
+                        body(chunk, begin, std::min(begin + grain_size, size));
+                    }
+                    catch (...)
+                    {
+                        if (!error_set.test_and_set())
+                            error = std::current_exception();
+                    }
+                    done.count_down();
+                }
+            }
+        };
+
+        /* Slot for a partial result of a chunked reduction, padded so that the slots written by different threads
+         * never share a cache line.
+         * @T Type of the partial result.
+         */
+        template<typename T>
+        struct padded_partial
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            bool constructed = false;
+            char padding[cache_line_size];
+
+            padded_partial() { }
+
+            padded_partial(const padded_partial<T> &) = delete;
+
+            ~padded_partial()
+            {
+                if (constructed)
+                    get().~T();
+            }
+
+            T &get() { return *reinterpret_cast<T *>(&storage); }
+
+            void set(T &&value)
+            {
+                ::new(static_cast<void *>(&storage)) T(std::move(value));
+                constructed = true;
+            }
+        };
+
+        /* Bounded single-producer/single-consumer ring of exceptions, one per worker of <thread_pool>.
+         *
+         * The worker records the exceptions without any locking, while the consumers (serialized by the pool)
+         * collect them. <push> fails when the ring is full, leaving the exception to a fallback queue.
+         */
+        class error_ring
+        {
+        public:
+            // Number of exceptions the ring can hold.
+            static const size_t capacity = 32;
+
+        protected:
+            std::exception_ptr slots[capacity];
+            // Index of the next slot to read, written by the consumer.
+            std::atomic<size_t> head{0};
+            // Index of the next slot to write, written by the producer.
+            std::atomic<size_t> tail{0};
+
+        public:
+            /* Record an exception. May only be called by the producer.
+             * @error Pointer to the exception.
+             *
+             * @return false if the ring is full.
+             */
+            bool push(std::exception_ptr error)
+            {
+                size_t index = tail.load(std::memory_order_relaxed);
+                if (index - head.load(std::memory_order_acquire) == capacity)
+                    return false;
+                slots[index % capacity] = std::move(error);
+                tail.store(index + 1, std::memory_order_release);
+                return true;
+            }
+
+            /* Take the oldest exception. May only be called by one consumer at a time.
+             * @error Set to the exception on success.
+             *
+             * @return false if the ring is empty.
+             */
+            bool pop(std::exception_ptr &error)
+            {
+                size_t index = head.load(std::memory_order_relaxed);
+                if (index == tail.load(std::memory_order_acquire))
+                    return false;
+                error = std::move(slots[index % capacity]);
+                slots[index % capacity] = nullptr;
+                head.store(index + 1, std::memory_order_release);
+                return true;
+            }
+        };
+    }
+
     /* Class providing a pool of workers, which can asynchronously perform selected tasks.
      *
-     * Currently, there are two strategies at which the tasks can be assigned and two
+     * Currently, there are four strategies at which the tasks can be assigned and two
      * methods of creating tasks.
      *
      * Strategies: (see <thread_pool::strategy>)
-     * Methods: <async>, <map>
+     * Methods: <async>, <map>, <for_each>, <parallel_for>, <reduce>, <transform_reduce>
      */
-    class thread_pool : protected mdl::exception_handler, protected mdl::handler
+    class thread_pool : public mdl::executor, protected mdl::exception_handler, protected mdl::handler
     {
     public:
         /* Strategies that can be used to assign tasks to workers */
@@ -57,25 +236,174 @@ namespace mdl
              * at random. <thread_pool> selects the one with a shorter message queue and queues
              * the new task.
              */
-            power2choices
+            power2choices,
+            /* In this strategy, each worker owns a lock-free work-stealing deque. Tasks created
+             * from within a worker are pushed to that worker's deque, while tasks created from
+             * outside of the <thread_pool> are posted to the workers in a round robin fashion
+             * and moved to their deques as they arrive. A worker executes tasks from its own deque
+             * (newest first) and, once it runs out of them, steals the oldest tasks of workers
+             * selected at random.
+             */
+            work_stealing
+        };
+
+        /* Modes of shutting the pool down (see <shutdown>) */
+        enum class shutdown_mode
+        {
+            // Run all the tasks submitted so far before stopping the workers.
+            drain,
+            // Let the workers finish the tasks they are running, and drop the tasks that haven't been started yet.
+            // The futures of the dropped tasks receive std::future_error with broken_promise.
+            cancel_pending
         };
 
     protected:
-        /* Implementation of <looper_thread> that keeps track of it's parent, and registers him as
-         * exception and message handler
+        /* Worker thread running a <looper>, similar to <looper_thread>, that keeps track of it's parent, and registers
+         * him as exception and message handler.
+         *
+         * Unlike <looper_thread>, the thread is not started by the constructor, but by <start>, and can be started
+         * again once the previous loop has finished and has been joined, so that the pool may retire and revive it.
          */
-        struct thread_handler : public looper_thread
+        struct thread_handler : public std::thread, public looper
         {
             thread_pool &parent;
             unsigned id;
+            // Set while the worker counts as one of the live workers of the pool, guarded by resize_lock.
+            bool live = false;
+
+            // Tasks owned by this worker in case of work_stealing task assignment strategy.
+            work_stealing_deque<message_ptr *> tasks;
+            // Random number generation engine for selecting the victims of work stealing.
+            std::minstd_rand victim_rng;
+            // Set once the deque has been relocated by the pinned thread. The CPU of a worker doesn't change, so the
+            // buffer stays local when the worker is retired and started again.
+            bool tasks_relocated = false;
+            // Set while the worker is (about to be) parked, waiting for new tasks.
+            std::atomic_bool idle{false};
+            // Exceptions thrown on this worker, collected by <thread_pool::collect_exceptions>.
+            helper::error_ring errors;
 
             thread_handler(unsigned id, thread_pool &parent) :
+                    looper(static_cast<std::thread &>(*this), static_cast<mdl::exception_handler &>(parent),
+                           static_cast<mdl::handler &>(parent)),
                     id(id),
                     parent(parent),
-                    looper_thread(static_cast<mdl::exception_handler &>(parent),
-                                  static_cast<mdl::handler &>(parent)) { }
+                    victim_rng(id + 1) { }
+
+            // Destructor, stops the loop, if it's running, and releases the tasks that have never been run.
+            ~thread_handler()
+            {
+                if (running || joinable())
+                    stop_and_join();
+                discard_pending();
+            }
+
+            // Start (or restart) the thread running the loop. The previous thread, if any, has to be joined.
+            void start()
+            {
+                is_started.store(false);
+                is_stopped.store(false);
+                static_cast<std::thread &>(*this) = std::thread([this]()
+                    {
+                        running_worker = this;
+                        loop();
+                    });
+            }
+
+            /* Release the messages and tasks that have never been handled, breaking the promises of the tasks.
+             * May only be called once the loop has finished.
+             *
+             * @return true if anything has been released.
+             */
+            bool discard_pending()
+            {
+                bool discarded = false;
+                message_ptr msg;
+                for (auto &queue : message_queues)
+                    while (queue.pop(msg))
+                        discarded = true;
+                msg = nullptr;
+                deferred_break = nullptr;
+                message_ptr *task;
+                while (tasks.pop(task))
+                {
+                    unbox_task(task);
+                    discarded = true;
+                }
+                return discarded;
+            }
         };
 
+        // Move the task into a pool-allocated box, which can be stored in a work_stealing_deque.
+        static message_ptr *box_task(message_ptr &&msg)
+        {
+            pool_allocator<message_ptr> alloc;
+            message_ptr *box = alloc.allocate(1);
+            alloc.construct(box, std::move(msg));
+            return box;
+        }
+
+        // Take the task out of the box created with <box_task>, releasing the box.
+        static message_ptr unbox_task(message_ptr *box)
+        {
+            pool_allocator<message_ptr> alloc;
+            message_ptr msg = std::move(*box);
+            alloc.destroy(box);
+            alloc.deallocate(box, 1);
+            return msg;
+        }
+
+        // Number of chunks per worker, when the chunked algorithms (<map>, <reduce>, ...) split the range automatically.
+        static const size_t chunks_per_worker = 4;
+
+        /* The size of chunks used to split n elements.
+         * @n Number of elements.
+         * @grain_size Requested size of chunks, or 0 to split the elements into <chunks_per_worker> chunks per worker.
+         */
+        size_t chunk_size(size_t n, size_t grain_size) const
+        {
+            return grain_size ? grain_size : std::max<size_t>(1, n / (processes * chunks_per_worker));
+        }
+
+        /* Split [0, n) into chunks and call body(chunk, begin, end) on each, using the workers and the calling thread.
+         * @n Number of elements.
+         * @grain_size Number of elements in a chunk, or 0 to pick it with <chunk_size>.
+         * @body Function processing a chunk.
+         *
+         * Up to one task per worker is created, each of them (and the calling thread) claims chunks until none are
+         * left. Returns once all chunks are done, rethrowing the first exception thrown by the body, if any.
+         */
+        template<typename Body>
+        void run_chunked(size_t n, size_t grain_size, Body body)
+        {
+            typedef helper::chunked_loop<Body> state_type;
+            if(n == 0) return;
+
+            auto state = std::allocate_shared<state_type>(pool_allocator<state_type>(), std::move(body), n,
+                                                          chunk_size(n, grain_size));
+            // The calling thread takes one share of the chunks itself
+            size_t helpers = std::min<size_t>(processes, state->chunks - 1);
+            for(size_t i = 0; i < helpers; ++i)
+                send_message(std::allocate_shared<post_call>(pool_allocator<post_call>(), [state]() { state->run(); }));
+
+            state->run();
+            state->done.wait();
+            if(state->error)
+                std::rethrow_exception(state->error);
+        }
+
+        // The worker running on the current thread (if any), used to detect tasks created from within workers.
+        static thread_local thread_handler *local_worker;
+
+        // The worker running on the current thread (if any), set when its loop starts, for all strategies.
+        static thread_local thread_handler *running_worker;
+
+        // The worker running on the current thread, nullptr if the thread doesn't belong to the pool.
+        thread_handler *current_worker() const
+        {
+            return running_worker != nullptr && &running_worker->parent == this ? running_worker : nullptr;
+        }
+
         // Implementation of <exception_handler> interface. Will enqueue pending exceptions in exception_queue.
         virtual void handle_exception(std::exception_ptr);
 
@@ -83,61 +411,341 @@ namespace mdl
         // dynamic task allocation.
         virtual bool handle_message(mdl::message_ptr);
 
-        // Constructor helper, enqueues empty_queue_guard messages for all workers.
-        void initialize_queues();
+        // Implementation of <handler> interface. Accepts only the message types <handle_message> is interested in.
+        virtual bool accepts(mdl::message_type) const;
+
+        /* Start the worker's thread, after asking it to pin itself to the CPU selected in worker_cpus and enqueueing
+         * the empty_queue_guard message, if needed. Has to be called under resize_lock (or by the constructor).
+         */
+        void start_worker(thread_handler &worker);
+
+        // Start one of the stopped workers, if all the live ones are busy and the pool may still grow.
+        void maybe_grow();
+
+        // Stop the worker (from its own thread), unless the pool can't shrink. Returns true, if it has been retired.
+        bool retire_worker(thread_handler &worker);
+
+        // Returns true, if the number of workers changes with the load.
+        bool is_elastic() const { return min_workers < processes && idle_timeout != duration_t::max(); }
+
+        // CPU selected for each of the workers by the placement policy, -1 if not pinned.
+        std::vector<int> worker_cpus;
+
+        // Returns true, if there are tasks awaiting to be picked up by idle workers (dynamic and work_stealing).
+        bool has_pending_tasks();
+
+        /* Park the worker until it receives a message or gets woken up by <wake_idle_worker>.
+         * @worker The worker running on the current thread.
+         * @deadline Time point after which to stop waiting.
+         *
+         * @return false if the deadline has passed.
+         */
+        bool park_worker(thread_handler &worker, time_point_t deadline = time_point_t::max());
+
+        // Wake up one of the parked workers, if any.
+        void wake_idle_worker();
+
+        // Returns true, if the current thread is one of this pool's workers (work_stealing and dynamic only).
+        bool is_local_worker() const { return local_worker != nullptr && &local_worker->parent == this; }
+
+        // The pool whose worker runs on the current thread (if any), set for all strategies.
+        static thread_local const thread_pool *local_pool;
+
+        // Returns true, if the current thread is one of this pool's workers.
+        bool is_pool_thread() const { return local_pool == this; }
+
+        /* Account for a new queued task, waiting for the number of queued tasks to drop below the limit.
+         * @deadline Time point after which to give up, time_point_t::max() to wait indefinitely, or
+         *  time_point_t::min() to give up immediately.
+         *
+         * Tasks submitted from the workers of the pool are never held back, since they might be the ones to drain it.
+         *
+         * @return true if the task may be submitted, false if the deadline has passed.
+         */
+        bool reserve_slot(time_point_t deadline);
+
+        // Account for a queued task being started, letting a blocked producer through.
+        void task_started();
+
+        // Take a task from the shared queues of the dynamic strategy. Returns false, if there are none.
+        bool pop_shared_task(message_ptr &task);
+
+        // Set once the pending tasks are to be dropped instead of run.
+        std::atomic_bool cancelling{false};
+
+        // Make the workers drop the pending tasks and stop as soon as they are done with the running ones.
+        void cancel_workers();
+
+        // Release the tasks left in the queues once the workers have been joined.
+        void discard_pending();
+
+        // Prevent the workers from being started or retired, before shutting the pool down.
+        void stop_resizing();
+
+        // Join the threads of all the workers, once they have been stopped.
+        void join_workers();
+
+        // Run a task received as a message, forwarding the exceptions to <handle_exception>.
+        void run_message(message_ptr msg);
+
+        // Try to steal a task from workers selected at random. Returns true on success.
+        bool steal_task(thread_handler &thief, message_ptr *&task);
+
+        // Run a task taken from a work-stealing deque, forwarding the exceptions to <handle_exception>.
+        void run_task(message_ptr *task);
+
+        // Number of tasks submitted, but not started yet.
+        std::atomic<size_t> pending_tasks{0};
+        // Bound on pending_tasks for the producers, 0 if unbounded.
+        std::atomic<size_t> pending_limit{0};
+        // Number of producers blocked in <reserve_slot>.
+        std::atomic<unsigned> capacity_waiters{0};
+        std::mutex capacity_lock;
+        std::condition_variable capacity_cv;
 
         typedef mdl::const_vector<thread_handler> pool_type;
         // Pool of all available <thread_handler>s.
         pool_type pool;
-        // Iterator to the next handler in case of round_robin task assignment strategy.
-        pool_type::iterator next_robin;
+        // Index (modulo processes) of the next handler in case of round_robin task assignment strategy, and of the
+        // tasks submitted from outside of the pool with work_stealing.
+        std::atomic<size_t> next_robin{0};
+        // Handle of the pool held by the futures of its tasks, detached on shutdown, so that the continuations
+        // attached afterwards are run in place instead of on a stopped (or destroyed) pool.
+        std::shared_ptr<executor_handle> continuation_handle{std::make_shared<executor_handle>(this)};
 
+        // Serializes the consumers of the error rings and guards exception_queue.
         std::mutex exception_queue_lock;
-        // Queue holding exception_ptr to all exceptions thrown in the workers.
+        // Queue holding exception_ptr to the exceptions, which didn't fit in the error rings of the workers.
         std::queue<std::exception_ptr> exception_queue;
 
         std::mutex task_queue_lock;
-        // Queue of messages to be assigned to workers in case of dynamic task assignment.
-        std::queue<message_ptr> task_queue;
+        // Queues of messages (one per <priority>) to be assigned to workers in case of dynamic task assignment.
+        std::queue<message_ptr, std::deque<message_ptr, pool_allocator<message_ptr>>> task_queues[priority_levels];
+        // Weighted selection between task_queues, guarded by task_queue_lock.
+        helper::lane_scheduler task_lanes;
+        // The largest number of tasks seen in task_queues at once, updated under task_queue_lock.
+        std::atomic<size_t> shared_high_water{0};
+
+        // Update shared_high_water with the current size of task_queues. Has to be called under task_queue_lock.
+        void record_shared_depth();
+
+        // Update the high-water mark of the local worker with the size of its deque (work_stealing only).
+        static void record_local_depth();
         
-        // Random number generation engine for task assignment using power2choices <strategy>
-        std::default_random_engine p2c_rng;
+        // Random number generation engine for task assignment using power2choices <strategy>, one per producer thread.
+        static std::default_random_engine &p2c_rng();
+
+        // Number of workers parked in <park_worker>.
+        std::atomic<unsigned> idle_workers{0};
 
 
         void throw_if_nonempty();
 
+        // Take the oldest of the collected exceptions. Has to be called under exception_queue_lock.
+        bool pop_exception(std::exception_ptr &error);
+
         void stop_and_join();
 
-        void send_message(message_ptr);
+        // Submit a task, bypassing the bound on the queued tasks.
+        void send_message(message_ptr, priority p = priority::normal);
+
+        // Assign the task to one of the workers, according to the strategy. The task has to be already accounted for.
+        void dispatch_message(message_ptr, priority p);
 
+        typedef std::vector<message_ptr>::iterator batch_iterator;
+
+        /* Submit a batch of tasks, accounting for them in as few steps as the bound on the queued tasks allows.
+         * @batch The tasks.
+         * @p Priority of the tasks.
+         */
+        void send_messages(std::vector<message_ptr> &batch, priority p);
+
+        /* Assign a batch of tasks to the workers at once, according to the strategy. The tasks have to be already
+         * accounted for.
+         * @first Iterator pointing to the first task of the batch (inkl.).
+         * @last Iterator pointing to the last task of the batch (excl.).
+         * @p Priority of the tasks.
+         */
+        void dispatch_messages(batch_iterator first, batch_iterator last, priority p);
+
+        /* Post contiguous slices of the batch to the workers.
+         * @first Iterator pointing to the first task of the batch.
+         * @shares Number of tasks to post to each of the workers, summing up to the size of the batch.
+         * @p Priority of the tasks.
+         */
+        void post_shares(batch_iterator first, const std::vector<size_t> &shares, priority p);
+
+        // Create a task message fulfilling the future with the result of fn(args...).
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        message_ptr
+        make_call(mdl::future<T> &future, Fn &&fn, Args &&... args)
+        {
+            // The promise state and the message come from the thread-cached block pool, while the bound function
+            // is stored inline in the post_call, so that submitting small tasks doesn't touch the global heap.
+            mdl::promise<T> promise(continuation_handle);
+            future = promise.get_future();
+            auto floc = std::bind<T>(std::forward<Fn>(fn), std::forward<Args>(args)...);
+            return std::allocate_shared<post_call>(
+                    pool_allocator<post_call>(),
+                    helper::async_call<T, decltype(floc)>(std::move(promise), std::move(floc)));
+        }
+
+        // Create a task message fulfilling the future with the result of fn(args...), unless cancelled before it runs.
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        message_ptr
+        make_cancellable_call(mdl::future<T> &future, cancellation_token token, Fn &&fn, Args &&... args)
+        {
+            mdl::promise<T> promise(continuation_handle);
+            future = promise.get_future();
+            auto floc = std::bind<T>(std::forward<Fn>(fn), std::forward<Args>(args)...);
+            return std::allocate_shared<post_call>(
+                    pool_allocator<post_call>(),
+                    helper::cancellable_call<T, decltype(floc)>(std::move(promise), std::move(token), std::move(floc)));
+        }
+
+        // Create a task (without accounting for it), fulfilling the returned future with the result of fn(args...).
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        dispatch_call(priority p, Fn &&fn, Args &&... args)
+        {
+            mdl::future<T> future;
+            dispatch_message(make_call(future, std::forward<Fn>(fn), std::forward<Args>(args)...), p);
+            return future;
+        }
+
+        // The maximum number of workers, i.e. the size of the pool.
         unsigned processes;
+        // The number of workers kept alive, even when idle.
+        unsigned min_workers;
+        // Time after which an idle worker above min_workers is retired.
+        duration_t idle_timeout;
+        // Number of the workers with a running (or starting) thread.
+        std::atomic<unsigned> live_workers{0};
+        // Guards starting and retiring the workers.
+        std::mutex resize_lock;
+        // Set by <shutdown>, guarded by resize_lock.
+        bool resizing_stopped = false;
         strategy task_assigning_strategy;
 
+        /* Create a <thread_pool> with between <min_workers> and <max_workers> workers.
+         * @min_workers Number of workers kept alive.
+         * @max_workers Maximum number of workers.
+         * @idle_timeout Time after which an idle worker above min_workers is retired, duration_t::max() for never.
+         * @task_assigning_strategy Strategy of assigning tasks to the workers.
+         * @placement Policy of pinning the workers to the CPUs.
+         */
+        thread_pool(unsigned min_workers, unsigned max_workers, duration_t idle_timeout,
+                    strategy task_assigning_strategy, placement_policy placement) :
+                worker_cpus(helper::plan_placement(helper::cpu_topology(), placement, max_workers)),
+                processes(max_workers),
+                min_workers(std::min(min_workers, max_workers)),
+                idle_timeout(idle_timeout),
+                task_assigning_strategy(task_assigning_strategy),
+                pool(pool_type::make_indexed(max_workers, *this))
+        {
+            for (unsigned i : range<unsigned>(this->min_workers))
+                start_worker(pool[i]);
+        }
+
     public:
         /* Create a <thread_pool> with <processes> workers and <task_assigning_strategy> strategy.
          * @processes Number of worker threads to create. Defaults to std::thread::hardware_concurrency() or 1, if undefined.
          * @task_assigning_strategy Strategy of assigning tasks to the workers. Defaults to strategy::round_robin.
+         * @placement Policy of pinning the workers to the CPUs (see <placement_policy>). Defaults to no pinning.
+         *
+         * Pinned workers pin themselves before handling any task and then reallocate their work-stealing deques
+         * and thread-cached pools from their own threads, so that with the default first-touch NUMA policy this
+         * memory is placed on their own nodes.
          */
         thread_pool(unsigned processes = helper::hw_concurrency(),
-                    strategy task_assigning_strategy = strategy::round_robin) :
-                processes(processes),
-                task_assigning_strategy(task_assigning_strategy),
-                pool(pool_type::make_indexed(processes, *this)),
-                next_robin(pool.begin()),
-                p2c_rng(std::chrono::system_clock::now().time_since_epoch().count())
-        {
-            initialize_queues();
-        }
+                    strategy task_assigning_strategy = strategy::round_robin,
+                    placement_policy placement = placement_policy::none) :
+                thread_pool(processes, processes, duration_t::max(), task_assigning_strategy, placement) { }
 
-        // Destructor. Joins all workers and blocks untill all the tasks are done.
+        /* Create an elastic <thread_pool>, growing and shrinking with the load.
+         * @min_workers Number of workers kept alive, even when idle (may be 0).
+         * @max_workers Maximum number of workers.
+         * @idle_timeout Time after which an idle worker above min_workers is retired, and its thread finished.
+         * @placement Policy of pinning the workers to the CPUs (see <placement_policy>). Defaults to no pinning.
+         *
+         * The pool uses strategy::dynamic, so that the tasks are never bound to a particular worker. Whenever a task
+         * is submitted while none of the live workers is idle, another worker is started, up to max_workers.
+         * A worker that stays idle for idle_timeout is retired, down to min_workers, and started again when needed.
+         */
+        thread_pool(unsigned min_workers, unsigned max_workers, duration_t idle_timeout,
+                    placement_policy placement = placement_policy::none) :
+                thread_pool(min_workers, max_workers, idle_timeout, strategy::dynamic, placement) { }
+
+        // Destructor. Joins all workers and blocks untill all the tasks are done (unless <shutdown> was called).
         ~thread_pool(void)
         {
+            continuation_handle->detach();
             stop_and_join();
         }
 
-        // The number of workers (threads).
+        /* Stop all the workers and join them.
+         * @mode Whether to run the pending tasks first (shutdown_mode::drain), or drop them.
+         *
+         * All workers are signalled at once and joined as soon as they finish. No tasks may be submitted to the pool
+         * afterwards; calling shutdown again has no effect. Continuations of the futures of the pool, scheduled from
+         * then on, are run in place by the thread completing (or continuing) the antecedent.
+         */
+        void shutdown(shutdown_mode mode = shutdown_mode::drain);
+
+        /* Stop all the workers and join them, draining the pending tasks until the deadline.
+         * @deadline Time point after which the remaining pending tasks are dropped (see shutdown_mode::cancel_pending).
+         *
+         * @return true if all the tasks have been run before the deadline.
+         */
+        bool shutdown_until(time_point_t deadline);
+
+        // The number of workers (threads), or the maximum number of workers of an elastic pool.
         mdl::const_accessor<unsigned> workers{processes};
 
+        // The number of workers with a running thread.
+        unsigned active_workers() const { return live_workers.load(); }
+
+        /* Return the CPU the worker has been pinned to.
+         * @worker Index of the worker.
+         *
+         * @return Index of the logical CPU selected by the placement policy, or -1 if the worker is not pinned.
+         */
+        int worker_cpu(unsigned worker) const { return worker_cpus.at(worker); }
+
+        /* Maximum number of queued tasks (submitted, but not started yet), after which <async> blocks and
+         * <try_async> fails. 0 (the default) means no limit.
+         *
+         * Tasks created by the workers themselves, continuations and the chunks of <map>, <reduce> etc. are
+         * counted, but never held back.
+         */
+        mdl::getset_accessor<size_t> max_queued_tasks = {
+                [&]()
+                    {
+                        return pending_limit.load();
+                    },
+                [&](const size_t &value)
+                    {
+                        pending_limit.store(value);
+                        { mutex_lock scope_lock(capacity_lock); }
+                        capacity_cv.notify_all();
+                    }
+        };
+
+        /* Number of times an idle worker yields before it parks its thread (see <looper_base::idle_spins>).
+         * Reads the value of the first worker, sets the value for all of them.
+         */
+        mdl::getset_accessor<unsigned> idle_spins = {
+                [&]()
+                    {
+                        return pool[0].idle_spins.get();
+                    },
+                [&](const unsigned &value)
+                    {
+                        for (auto &worker : pool)
+                            worker.idle_spins = value;
+                    }
+        };
+
         /* Execute the function asynchronously.
          * @fn Function to call.
          * @args... Function arguments.
@@ -148,22 +756,195 @@ namespace mdl
          *   which might cause problems with some complex or uncopyable types, so it's better to
          *   explicitly envelop all references with reference_wrappers, etc.
          *
-         * @return std::future<T>, where T is the result type of Fn(Args...), which will hold the
-         * result of the fn(args...) once finished.
+         * If <max_queued_tasks> is set and reached, blocks until one of the queued tasks is started
+         * (unless called from one of the workers).
+         *
+         * @return mdl::future<T>, where T is the result type of Fn(Args...), which will hold the
+         * result of the fn(args...) (or the exception it has thrown) once finished. Continuations attached
+         * to it with <future::then> are run on this pool.
          */
         template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
-        std::future<T>
+        mdl::future<T>
         async(Fn &&fn, Args &&... args)
         {
-            std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
-            //auto floc = std::forward<Fn>(fn);
-            auto floc = std::bind<T, Fn, Args...>(std::forward<Fn>(fn), std::forward<Args>(args)...);
-            auto lambda = [promise, floc](void) mutable
-                { promise->set_value(floc()); };
-            send_message(std::make_shared<post_call>(lambda));
-            return promise->get_future();
+            reserve_slot(time_point_t::max());
+            return dispatch_call(priority::normal, std::forward<Fn>(fn), std::forward<Args>(args)...);
+        };
+
+        /* Execute the function asynchronously with the given priority.
+         * @p Priority of the task. More urgent tasks are picked up by the workers first, while the less urgent ones
+         *  still get their share (see <helper::lane_scheduler>). Under strategy::work_stealing the priorities apply
+         *  to the tasks posted from outside of the pool, until they are moved to the deques; critical tasks are run
+         *  as soon as they reach a worker.
+         * @fn Function to call.
+         * @args... Function arguments.
+         *
+         * See <async>.
+         */
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        async(priority p, Fn &&fn, Args &&... args)
+        {
+            reserve_slot(time_point_t::max());
+            return dispatch_call(p, std::forward<Fn>(fn), std::forward<Args>(args)...);
+        };
+
+        /* Execute the function asynchronously, unless cancelled before it starts.
+         * @token Token checked when a worker picks the task up; if it has been cancelled by then, fn is not called
+         *  and the future holds <operation_cancelled_exception>. Once started, fn may poll the token (captured or
+         *  passed among args) to stop early.
+         * @fn Function to call.
+         * @args... Function arguments.
+         *
+         * See <async>.
+         */
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        async(cancellation_token token, Fn &&fn, Args &&... args)
+        {
+            reserve_slot(time_point_t::max());
+            mdl::future<T> future;
+            dispatch_message(make_cancellable_call(future, std::move(token), std::forward<Fn>(fn),
+                                                   std::forward<Args>(args)...), priority::normal);
+            return future;
+        };
+
+        /* Execute the function asynchronously, if the number of queued tasks is below <max_queued_tasks>.
+         * @fn Function to call.
+         * @args... Function arguments.
+         *
+         * See <async>.
+         *
+         * @return mdl::future<T> holding the result of fn(args...), or an invalid future (see <future::valid>),
+         * if the queue is full.
+         */
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        try_async(Fn &&fn, Args &&... args)
+        {
+            if (!reserve_slot(time_point_t::min()))
+                return mdl::future<T>();
+            return dispatch_call(priority::normal, std::forward<Fn>(fn), std::forward<Args>(args)...);
         };
 
+        /* Execute the function asynchronously, waiting at most <timeout> for the number of queued tasks to drop
+         * below <max_queued_tasks>.
+         * @timeout Maximum time to wait.
+         * @fn Function to call.
+         * @args... Function arguments.
+         *
+         * See <async>.
+         *
+         * @return mdl::future<T> holding the result of fn(args...), or an invalid future (see <future::valid>),
+         * if the queue was still full after <timeout>.
+         */
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        try_async_for(duration_t timeout, Fn &&fn, Args &&... args)
+        {
+            return try_async_until(helper::delay_by(timeout), std::forward<Fn>(fn), std::forward<Args>(args)...);
+        };
+
+        /* Execute the function asynchronously, waiting until <deadline> at most for the number of queued tasks to
+         * drop below <max_queued_tasks>.
+         * @deadline Time point after which to give up.
+         * @fn Function to call.
+         * @args... Function arguments.
+         *
+         * See <async>.
+         *
+         * @return mdl::future<T> holding the result of fn(args...), or an invalid future (see <future::valid>),
+         * if the queue was still full at <deadline>.
+         */
+        template<typename Fn, typename... Args, typename T = typename std::result_of<Fn(Args...)>::type>
+        mdl::future<T>
+        try_async_until(time_point_t deadline, Fn &&fn, Args &&... args)
+        {
+            if (!reserve_slot(deadline))
+                return mdl::future<T>();
+            return dispatch_call(priority::normal, std::forward<Fn>(fn), std::forward<Args>(args)...);
+        };
+
+        /* Execute the function asynchronously on all elements of a range, submitting all the tasks at once.
+         * @first Input iterator pointing to the first element of the range (inkl.).
+         * @last Input iterator pointing to the last element of the range (excl.).
+         * @function Function to call on each element, in a separate task.
+         * @p Priority of the tasks (see <async>).
+         *
+         * Unlike a loop of <async> calls, the whole batch is accounted for and assigned at once: under
+         * strategy::dynamic the shared queue is locked once, under strategy::power2choices the batch is spread
+         * over all workers so as to even out their queues, and each worker receives its share of the batch with
+         * a single push. If <max_queued_tasks> is set, the batch is submitted in pieces as the capacity allows.
+         *
+         * @return Futures holding the results of function(element), in the order of elements.
+         */
+        template<typename InputIterator, typename Fn, typename T = typename std::result_of<
+                Fn(typename std::iterator_traits<InputIterator>::value_type)>::type>
+        std::vector<mdl::future<T>>
+        async_bulk(InputIterator first, InputIterator last, Fn function, priority p = priority::normal)
+        {
+            std::vector<mdl::future<T>> futures;
+            std::vector<message_ptr> batch;
+            for (; first != last; ++first)
+            {
+                futures.emplace_back();
+                batch.push_back(make_call(futures.back(), function, *first));
+            }
+            send_messages(batch, p);
+            return futures;
+        }
+
+        /* Execute the function asynchronously on all values of the <range>, submitting all the tasks at once.
+         * @values The range of values.
+         * @function Function to call on each value, in a separate task.
+         * @p Priority of the tasks.
+         *
+         * Equivalent to <async_bulk(values.begin(), values.end(), function, p)>.
+         */
+        template<typename T, typename Fn, typename R = typename std::result_of<Fn(T)>::type>
+        std::vector<mdl::future<R>>
+        async_bulk(const range<T> &values, Fn function, priority p = priority::normal)
+        {
+            return async_bulk(values.begin(), values.end(), std::move(function), p);
+        }
+
+        /* Run the task on one of the workers (see <executor>).
+         * @t The task to run.
+         */
+        virtual void execute(task t)
+        {
+            send_message(std::allocate_shared<post_call>(pool_allocator<post_call>(), std::move(t)));
+        }
+
+        /* Awaiter returned by <schedule>, resuming the coroutine on one of the workers. */
+        struct resume_awaiter
+        {
+            thread_pool &target;
+            priority p;
+
+            bool await_ready() const { return false; }
+
+            template<typename Handle>
+            void await_suspend(Handle handle)
+            {
+                target.send_message(std::allocate_shared<post_call>(pool_allocator<post_call>(),
+                                                                    helper::resume_call<Handle>(handle)), p);
+            }
+
+            void await_resume() { }
+        };
+
+        /* co_await pool.schedule() suspends the coroutine (see coroutine.hpp) and resumes it on one of the workers,
+         * like a task submitted with <async>.
+         * @p Priority of the resumption.
+         *
+         * If the pool is shut down with shutdown_mode::cancel_pending before the coroutine is resumed, it is
+         * destroyed instead.
+         *
+         * @return Awaiter, to be used with co_await.
+         */
+        resume_awaiter schedule(priority p = priority::normal) { return resume_awaiter{*this, p}; }
+
         /* Map all values from one range into another asynchronously.
          * @first Random access iterator pointing to the first element of the range (inkl.).
          * @last Random access iterator pointing to the last element of the range (excl.).
@@ -171,13 +952,14 @@ namespace mdl
          * @function Function to call on all elements of range [first, last), which results will
          *  be stored in [output_first, output_first + (last - first))
          *
-         * Each task is created with an <async> call. One additional thread is spawned (using std::async)
-         * to keep track of promise of completing the map operation.
+         * One task per element is created, all of them submitted at once (see <async_bulk>), and the results are
+         * joined with <when_all_aggregate>, so no thread is blocked waiting for them.
          *
-         * @return std::future that becomes fulfilled once all elements are mapped.
+         * @return mdl::future that becomes fulfilled once all elements are mapped. If any of the calls throw, it
+         * holds an <exception_list> with all of the exceptions, in the order of elements.
          */
         template<typename RandomAccessIteratorIn, typename RandomAccessIteratorOut, typename Fn>
-        std::future<void>
+        mdl::future<void>
         map(RandomAccessIteratorIn first, RandomAccessIteratorIn last, RandomAccessIteratorOut output_first, Fn function)
         {
             typedef typename std::iterator_traits<RandomAccessIteratorIn>::value_type value_type;
@@ -190,32 +972,234 @@ namespace mdl
             ptrdiff_t n = std::distance(first, last);
             if(n < 0) mdl_throw(make_ia_exception, "Invalid iterator range", "first, last", std::make_pair(first, last));
             
-            // Create n async tasks for all elements in range:
-            auto futures = std::make_shared<const_vector<std::future<bool>>>(n);
-            for(size_t i = 0; first != last; ++first, ++output_first, ++i)
+            // Create n tasks for all elements in range, and submit them as one batch:
+            std::vector<mdl::future<void>> futures(n);
+            std::vector<message_ptr> batch;
+            batch.reserve(n);
+            for(ptrdiff_t i = 0; first != last; ++first, ++output_first, ++i)
             {
-                futures->at(i) = async([first, output_first, function] ()
+                batch.push_back(make_call(futures[i], [first, output_first, function] ()
                     {
                         *output_first = function(*first);
-                        return true;
-                    });
+                    }));
             }
-            
-            // Return an async task that collects all the jobs and returns one they are done.
-            return std::async([futures]()
-                                  {
-                                      for(auto& job : (*futures))
-                                          job.get();
-                                      return;
-                                  });
+            send_messages(batch, priority::normal);
+
+            // Return a future that becomes ready once all the jobs are done.
+            return when_all_aggregate(std::move(futures));
         }
-        
+
+        /* Map all values from one range into another asynchronously, unless cancelled.
+         * @first Random access iterator pointing to the first element of the range (inkl.).
+         * @last Random access iterator pointing to the last element of the range (excl.).
+         * @output_first Random access iterator pointing to the first element of the output range.
+         * @function Function to call on all elements of range [first, last), which results will
+         *  be stored in [output_first, output_first + (last - first))
+         * @token Token checked before mapping each of the elements; the elements still queued once it is cancelled
+         *  are skipped, leaving their outputs untouched.
+         *
+         * See <map>.
+         *
+         * @return mdl::future that becomes fulfilled once all elements are mapped or skipped. If the token has been
+         * cancelled by then, it holds <operation_cancelled_exception>, otherwise an <exception_list> if any of the
+         * calls throw.
+         */
+        template<typename RandomAccessIteratorIn, typename RandomAccessIteratorOut, typename Fn>
+        mdl::future<void>
+        map(RandomAccessIteratorIn first, RandomAccessIteratorIn last, RandomAccessIteratorOut output_first, Fn function,
+            cancellation_token token)
+        {
+            typedef typename std::iterator_traits<RandomAccessIteratorIn>::value_type value_type;
+            typedef typename std::iterator_traits<RandomAccessIteratorOut>::value_type result_type;
+            typedef typename std::result_of<Fn(value_type)>::type function_result_type;
+
+            static_assert(std::is_convertible<function_result_type, result_type>::value, "Function return type not convertible to iterator value_type");
+
+            ptrdiff_t n = std::distance(first, last);
+            if(n < 0) mdl_throw(make_ia_exception, "Invalid iterator range", "first, last", std::make_pair(first, last));
+
+            std::vector<mdl::future<void>> futures(n);
+            std::vector<message_ptr> batch;
+            batch.reserve(n);
+            for(ptrdiff_t i = 0; first != last; ++first, ++output_first, ++i)
+            {
+                batch.push_back(make_call(futures[i], [first, output_first, function, token] ()
+                    {
+                        if (!token.is_cancelled())
+                            *output_first = function(*first);
+                    }));
+            }
+            send_messages(batch, priority::normal);
+
+            // Report the cancellation once, instead of once per skipped element.
+            return when_all_aggregate(std::move(futures)).then([token]()
+                {
+                    token.throw_if_cancelled();
+                });
+        }
+
+        /* Map all values from one range into another, splitting the range into contiguous chunks.
+         * @first Random access iterator pointing to the first element of the range (inkl.).
+         * @last Random access iterator pointing to the last element of the range (excl.).
+         * @output_first Random access iterator pointing to the first element of the output range.
+         * @function Function to call on all elements of range [first, last), which results will
+         *  be stored in [output_first, output_first + (last - first))
+         * @grain_size Number of elements in a chunk, or 0 to split the range into a few chunks per worker.
+         *
+         * Up to one task per worker is created, each of them (and the calling thread) claims chunks until none
+         * are left, so the overhead doesn't depend on the number of elements. The calling thread helps mapping
+         * instead of blocking, and returns once all chunks are done. If the function throws, the remaining
+         * elements of the chunk are skipped, and the first exception is rethrown in the calling thread.
+         */
+        template<typename RandomAccessIteratorIn, typename RandomAccessIteratorOut, typename Fn>
+        void
+        map(RandomAccessIteratorIn first, RandomAccessIteratorIn last, RandomAccessIteratorOut output_first, Fn function,
+            size_t grain_size)
+        {
+            typedef typename std::iterator_traits<RandomAccessIteratorIn>::value_type value_type;
+            typedef typename std::iterator_traits<RandomAccessIteratorOut>::value_type result_type;
+            typedef typename std::result_of<Fn(value_type)>::type function_result_type;
+
+            static_assert(std::is_convertible<function_result_type, result_type>::value, "Function return type not convertible to iterator value_type");
+
+            ptrdiff_t n = std::distance(first, last);
+            if(n < 0) mdl_throw(make_ia_exception, "Invalid iterator range", "first, last", std::make_pair(first, last));
+
+            run_chunked(n, grain_size, [first, output_first, function](size_t, size_t begin, size_t end)
+                {
+                    RandomAccessIteratorIn in = first + begin;
+                    RandomAccessIteratorOut out = output_first + begin;
+                    for (size_t i = begin; i != end; ++i, ++in, ++out)
+                        *out = function(*in);
+                });
+        }
+
+        /* Call the function on all elements of a range, splitting the range into contiguous chunks.
+         * @first Random access iterator pointing to the first element of the range (inkl.).
+         * @last Random access iterator pointing to the last element of the range (excl.).
+         * @function Function to call on all elements of range [first, last).
+         * @grain_size Number of elements in a chunk, or 0 to split the range into a few chunks per worker.
+         *
+         * Runs the same way as the chunked <map>, the calling thread returns once all elements are processed.
+         */
+        template<typename RandomAccessIterator, typename Fn>
+        void
+        for_each(RandomAccessIterator first, RandomAccessIterator last, Fn function, size_t grain_size = 0)
+        {
+            ptrdiff_t n = std::distance(first, last);
+            if(n < 0) mdl_throw(make_ia_exception, "Invalid iterator range", "first, last", std::make_pair(first, last));
+
+            run_chunked(n, grain_size, [first, function](size_t, size_t begin, size_t end)
+                {
+                    RandomAccessIterator it = first + begin;
+                    for (size_t i = begin; i != end; ++i, ++it)
+                        function(*it);
+                });
+        }
+
+        /* Call the function on all values of the <range>, splitting it into contiguous chunks.
+         * @values The range of values.
+         * @function Function to call on all values.
+         * @grain_size Number of values in a chunk, or 0 to split the range into a few chunks per worker.
+         *
+         * Equivalent to <for_each(values.begin(), values.end(), function, grain_size)>.
+         */
+        template<typename T, typename Fn>
+        void
+        parallel_for(const range<T> &values, Fn function, size_t grain_size = 0)
+        {
+            for_each(values.begin(), values.end(), std::move(function), grain_size);
+        }
+
+        /* Transform all elements of a range and reduce the results, splitting the range into contiguous chunks.
+         * @first Random access iterator pointing to the first element of the range (inkl.).
+         * @last Random access iterator pointing to the last element of the range (excl.).
+         * @init The initial value of the reduction.
+         * @reduce_op Associative binary function combining two (partial) results.
+         * @transform_op Function called on all elements of range [first, last).
+         * @grain_size Number of elements in a chunk, or 0 to split the range into a few chunks per worker.
+         *
+         * Each chunk is reduced separately into its own padded slot, and the partial results are then combined
+         * in the order of chunks by the calling thread, so reduce_op doesn't have to be commutative.
+         *
+         * @return init reduced with transform_op applied to all elements.
+         */
+        template<typename RandomAccessIterator, typename T, typename BinaryOp, typename UnaryOp>
+        T
+        transform_reduce(RandomAccessIterator first, RandomAccessIterator last, T init, BinaryOp reduce_op,
+                         UnaryOp transform_op, size_t grain_size = 0)
+        {
+            ptrdiff_t n = std::distance(first, last);
+            if(n < 0) mdl_throw(make_ia_exception, "Invalid iterator range", "first, last", std::make_pair(first, last));
+            if(n == 0) return init;
+
+            grain_size = chunk_size(n, grain_size);
+            const_vector<helper::padded_partial<T>> partials((n + grain_size - 1) / grain_size);
+            helper::padded_partial<T> *slots = &partials[0];
+
+            run_chunked(n, grain_size, [first, reduce_op, transform_op, slots](size_t chunk, size_t begin, size_t end)
+                {
+                    RandomAccessIterator it = first + begin;
+                    T partial = transform_op(*it);
+                    for (size_t i = begin + 1; i != end; ++i)
+                        partial = reduce_op(std::move(partial), transform_op(*++it));
+                    slots[chunk].set(std::move(partial));
+                });
+
+            for (auto &partial : partials)
+                init = reduce_op(std::move(init), std::move(partial.get()));
+            return init;
+        }
+
+        /* Reduce all elements of a range, splitting the range into contiguous chunks.
+         * @first Random access iterator pointing to the first element of the range (inkl.).
+         * @last Random access iterator pointing to the last element of the range (excl.).
+         * @init The initial value of the reduction.
+         * @reduce_op Associative binary function combining two (partial) results, std::plus<T> by default.
+         * @grain_size Number of elements in a chunk, or 0 to split the range into a few chunks per worker.
+         *
+         * See <transform_reduce>.
+         *
+         * @return init reduced with all elements.
+         */
+        template<typename RandomAccessIterator, typename T, typename BinaryOp = std::plus<T>>
+        T
+        reduce(RandomAccessIterator first, RandomAccessIterator last, T init, BinaryOp reduce_op = BinaryOp(),
+               size_t grain_size = 0)
+        {
+            typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+            return transform_reduce(first, last, std::move(init), std::move(reduce_op),
+                                    [](const value_type &value) -> T { return value; }, grain_size);
+        }
+
+        /* Take all the exceptions collected so far from the tasks and handlers run by the workers.
+         *
+         * The tasks created with <async>, <map> etc. deliver their exceptions through the returned futures; this
+         * collects the ones that had nowhere else to go (e.g. thrown by the tasks run with <execute>). Each worker
+         * records them in its own lock-free ring, so a storm of failures doesn't serialize the workers.
+         *
+         * @return <exception_list> of the exceptions, empty if there were none.
+         */
+        exception_list collect_exceptions();
+
         /* Return the number of tasks awaiting in message queues.
-         * Can be used, when spawning large amounts of tasks, to pause the spawner process until the queue empties a little.
+         * Can be used, when spawning large amounts of tasks, to pause the spawner process until the queue empties a little
+         * (see also <max_queued_tasks>).
          *
-         * @return number of awaiting tasks in case of strategy::dynamic.
+         * @return number of tasks submitted, but not started yet. Read from a single counter, without touching the workers.
          */
         size_t get_awaiting_tasks() const;
+
+        /* Take a snapshot of the scheduling counters of all workers (see <looper::metrics>): tasks executed,
+         * queue depth high-water marks, time spent running tasks and idle, wakeups and steals.
+         *
+         * Meant for comparing the task assigning strategies on a given workload; the counters are kept by each
+         * worker with relaxed atomics, so reading them doesn't slow the workers down, but the values may be
+         * slightly out of date.
+         *
+         * @return The counters accumulated since the pool has been created.
+         */
+        thread_pool_metrics metrics() const;
     };
 }
 
@@ -0,0 +1,67 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_TOPOLOGY_HPP
+#define MDLUTILS_MULTITHREADING_TOPOLOGY_HPP
+
+#include <vector>
+
+namespace mdl
+{
+    /* Description of a logical CPU the process is allowed to run on. */
+    struct cpu_info
+    {
+        // Index of the logical CPU.
+        int cpu;
+        // Physical package (socket).
+        int package;
+        // Physical core within the package, shared by the hardware threads (SMT siblings).
+        int core;
+        // NUMA node.
+        int node;
+    };
+
+    /* Policies of placing worker threads on the CPUs. */
+    enum class placement_policy
+    {
+        // Workers are not pinned, the OS scheduler places them freely.
+        none,
+        /* Workers are pinned to consecutive logical CPUs, filling the hardware threads of a core,
+         * then the cores of a package, before moving on to the next package. */
+        compact,
+        /* Workers are spread across the packages (and the cores within them) first, using the additional
+         * hardware threads of the cores only once all the cores are taken. */
+        scatter,
+        /* Each worker is pinned to the first hardware thread of a different physical core (packages filled
+         * one after another). If there are more workers than cores, the assignment wraps around. */
+        physical_cores
+    };
+
+    namespace helper
+    {
+        /* Read the topology of the CPUs available to the process (from sysfs on Linux).
+         *
+         * @return Descriptions of the available logical CPUs, ordered by index; empty if unknown.
+         */
+        std::vector<cpu_info> cpu_topology();
+
+        /* Select a CPU for each worker according to the policy.
+         * @cpus Available CPUs, see <cpu_topology>.
+         * @policy The placement policy.
+         * @workers Number of workers.
+         *
+         * @return Index of the logical CPU for each of the workers, or -1 for workers which should not be pinned.
+         */
+        std::vector<int> plan_placement(const std::vector<cpu_info> &cpus, placement_policy policy, unsigned workers);
+
+        /* Pin the calling thread to the logical CPU (migrating it there).
+         * @cpu Index of the logical CPU.
+         *
+         * @return true on success, false if pinning is not supported or failed.
+         */
+        bool pin_current_thread(int cpu);
+    }
+}
+
+#endif //MDLUTILS_MULTITHREADING_TOPOLOGY_HPP
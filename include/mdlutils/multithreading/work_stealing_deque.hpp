@@ -0,0 +1,188 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+#define MDLUTILS_MULTITHREADING_WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace mdl
+{
+    /* Lock-free Chase-Lev work-stealing deque.
+     * @T Type of the stored elements, has to be trivially copyable (pointers are the intended use).
+     *
+     * The owner thread pushes and pops elements at the bottom end (LIFO), while any number of thief threads
+     * may concurrently steal elements from the top end (FIFO). The implementation follows "Correct and Efficient
+     * Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+     *
+     * The underlying circular buffer grows when full. Retired buffers are kept until the deque is destroyed,
+     * since thieves might still be reading from them.
+     */
+    template<typename T>
+    class work_stealing_deque
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "work_stealing_deque requires a trivially copyable type");
+
+    protected:
+        // Circular buffer holding the elements, indexed modulo its (power of two) capacity.
+        struct circular_buffer
+        {
+            int64_t capacity;
+            int64_t mask;
+            std::atomic<T> *items;
+
+            circular_buffer(int64_t capacity) : capacity(capacity), mask(capacity - 1),
+                                                items(new std::atomic<T>[capacity]) { }
+
+            ~circular_buffer() { delete[] items; }
+
+            T get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+
+            void put(int64_t index, T value) { items[index & mask].store(value, std::memory_order_relaxed); }
+
+            /* Create a buffer with the given capacity, holding the elements [top, bottom) of this one. */
+            circular_buffer *copy(int64_t top, int64_t bottom, int64_t new_capacity) const
+            {
+                circular_buffer *result = new circular_buffer(new_capacity);
+                for (int64_t i = top; i != bottom; ++i)
+                    result->put(i, get(i));
+                return result;
+            }
+        };
+
+        // Index of the next element to steal.
+        std::atomic<int64_t> top{0};
+        // Index of the next free slot at the owner's end.
+        std::atomic<int64_t> bottom{0};
+        // Buffer currently in use.
+        std::atomic<circular_buffer *> buffer;
+        // Buffers replaced by push() or relocate(), owned by the deque until destruction. Accessed only by the owner.
+        std::vector<circular_buffer *> retired;
+
+    public:
+        /* Create an empty deque.
+         * @capacity Initial capacity of the underlying buffer, rounded up to a power of two.
+         */
+        work_stealing_deque(size_t capacity = 64)
+        {
+            int64_t size = 1;
+            while (size < static_cast<int64_t>(capacity)) size <<= 1;
+            buffer.store(new circular_buffer(size), std::memory_order_relaxed);
+        }
+
+        // Copy constructor, deleted.
+        work_stealing_deque(const work_stealing_deque<T> &) = delete;
+
+        // Destructor, releases current and retired buffers (does not touch the stored values).
+        ~work_stealing_deque()
+        {
+            delete buffer.load(std::memory_order_relaxed);
+            for (circular_buffer *old : retired)
+                delete old;
+        }
+
+        /* Push a new element at the bottom of the deque. May only be called by the owner thread.
+         * @value The element to push.
+         */
+        void push(T value)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            circular_buffer *a = buffer.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1) // the buffer is full
+            {
+                retired.push_back(a);
+                a = a->copy(t, b, a->capacity * 2);
+                buffer.store(a, std::memory_order_release);
+            }
+            a->put(b, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /* Move the elements to a newly allocated buffer of the same capacity. May only be called by the owner thread.
+         *
+         * Lets the owner place the buffer in its local memory (e.g. on its own NUMA node, with the first-touch policy).
+         */
+        void relocate()
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            circular_buffer *a = buffer.load(std::memory_order_relaxed);
+            retired.push_back(a);
+            buffer.store(a->copy(t, b, a->capacity), std::memory_order_release);
+        }
+
+        /* Pop an element from the bottom of the deque. May only be called by the owner thread.
+         * @value Set to the popped element on success.
+         *
+         * @return true if an element has been popped, false if the deque was empty.
+         */
+        bool pop(T &value)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            circular_buffer *a = buffer.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) // the deque was empty
+            {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            value = a->get(b);
+            if (t == b) // the last element, race against the thieves
+            {
+                bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                       std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /* Steal an element from the top of the deque. May be called by any thread.
+         * @value Set to the stolen element on success.
+         *
+         * @return true if an element has been stolen, false if the deque was empty or the race was lost.
+         */
+        bool steal(T &value)
+        {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b) // the deque is empty
+                return false;
+
+            circular_buffer *a = buffer.load(std::memory_order_acquire);
+            value = a->get(t);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        /* Approximate the number of elements in the deque.
+         *
+         * @return Number of elements in the deque at some point during the call.
+         */
+        size_t size() const
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        /* Checks whether the deque is (approximately) empty.
+         *
+         * @return true if the deque had no elements at some point during the call.
+         */
+        bool empty() const { return !size(); }
+    };
+}
+
+#endif //MDLUTILS_MULTITHREADING_WORK_STEALING_DEQUE_HPP
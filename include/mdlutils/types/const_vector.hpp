@@ -42,6 +42,8 @@ namespace mdl
 
 
     protected:
+        // Allocator traits, used instead of the allocator members removed from std::allocator in C++20.
+        typedef std::allocator_traits<allocator_type> alloc_traits;
         // Pointer to the beginning of the array
         pointer p_begin;
         /* Pointer to the place in memory after the last in the array
@@ -68,7 +70,7 @@ namespace mdl
                 p_end(p_begin + size)
         {
             while (size--)
-                alloc.construct(&p_begin[size]);
+                alloc_traits::construct(alloc, &p_begin[size]);
         }
 
         /* Forward-constructor, allocates <size> objects and invokes their constructors using the parameters in <args>.
@@ -83,7 +85,7 @@ namespace mdl
                 p_end(p_begin + size)
         {
             while (size--)
-                this->construct(&p_begin[size], args...);
+                alloc_traits::construct(*this, &p_begin[size], args...);
         }
 
         // Copy constructor, deleted.
@@ -104,7 +106,7 @@ namespace mdl
         {
             if(p_begin == nullptr || p_end == nullptr) return; // the content has been already moved.
             for (reference p : (*this))
-                this->destroy(this->address(p));
+                alloc_traits::destroy(*this, std::addressof(p));
             this->deallocate(p_begin, p_end - p_begin);
             return;
         }
@@ -266,7 +268,7 @@ namespace mdl
         {
             const_vector<T, Alloc> result(size, nullptr);
             while (size--)
-                result.construct(&(result.p_begin[size]), size, args...);
+                alloc_traits::construct(static_cast<Alloc &>(result), &(result.p_begin[size]), size, args...);
             return result;
         };
 
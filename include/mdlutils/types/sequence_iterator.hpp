@@ -5,16 +5,25 @@
 #ifndef MDLUTILS_TYPES_SEQUENCE_ITERATOR_HPP
 #define MDLUTILS_TYPES_SEQUENCE_ITERATOR_HPP
 
+#include <cstddef>
+#include <iterator>
+
 #include <mdlutils/exceptions/invalid_argument_exception.hpp>
 
 namespace mdl
 {
     template <typename T>
-    class sequence_iterator : public std::iterator<std::random_access_iterator_tag, T>
+    class sequence_iterator
     {
     protected:
         T current, offset;
     public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
         sequence_iterator(T val, T offset = T(1)) : current(val), offset(offset)
         {
             if(offset == T(0))
@@ -49,37 +58,35 @@ namespace mdl
             return tmp;
         }
 
-        template <typename integer, typename std::enable_if<std::is_integral<integer>::value>::type>
-        sequence_iterator<T> operator+=(integer n)
+        template <typename integer, typename = typename std::enable_if<std::is_integral<integer>::value>::type>
+        sequence_iterator<T> &operator+=(integer n)
         {
-            if(n < 0) return operator-=(-n);
-            for(; n > 0; --n) operator++();
+            current += offset * T(n);
             return *this;
         }
 
-        template <typename integer, typename std::enable_if<std::is_integral<integer>::value>::type>
-        sequence_iterator<T> operator-=(integer n)
+        template <typename integer, typename = typename std::enable_if<std::is_integral<integer>::value>::type>
+        sequence_iterator<T> &operator-=(integer n)
         {
-            if(n < 0) return operator+=(-n);
-            for(; n > 0; --n) operator--();
+            current -= offset * T(n);
             return *this;
         }
 
-        template <typename integer, typename std::enable_if<std::is_integral<integer>::value>::type>
-        sequence_iterator<T> operator+(integer n)
+        template <typename integer, typename = typename std::enable_if<std::is_integral<integer>::value>::type>
+        sequence_iterator<T> operator+(integer n) const
         {
             sequence_iterator<T> it(*this);
             return it += n;
         }
 
-        template <typename integer, typename std::enable_if<std::is_integral<integer>::value>::type>
-        sequence_iterator<T> operator-(integer n)
+        template <typename integer, typename = typename std::enable_if<std::is_integral<integer>::value>::type>
+        sequence_iterator<T> operator-(integer n) const
         {
             sequence_iterator<T> it(*this);
             return it -= n;
         }
 
-        ptrdiff_t operator-(sequence_iterator<T> b)
+        ptrdiff_t operator-(const sequence_iterator<T> &b) const
         {
             if(b.offset != offset)
                 mdl_throw(invalid_argument_exception<T>, "Invalid sequence iterator subtraction - different offsets. Expected " + stringify(offset), "b.offset", b.offset);
@@ -106,9 +113,9 @@ namespace mdl
 
         T*operator ->() { return &current; }
 
-        T operator[] (ptrdiff_t n)
+        T operator[] (ptrdiff_t n) const
         {
-            return (*this) + n;
+            return *((*this) + n);
         }
 
         /*
@@ -117,7 +124,7 @@ namespace mdl
 
     };
 
-    template <typename T, typename integer, typename std::enable_if<std::is_integral<integer>::value>::type >
+    template <typename T, typename integer, typename = typename std::enable_if<std::is_integral<integer>::value>::type >
     sequence_iterator<T> operator+(integer n, sequence_iterator<T> it)
     {
         return it + n;
@@ -5,25 +5,44 @@
 #ifndef MDLUTILS_SORTED_LIST_HPP
 #define MDLUTILS_SORTED_LIST_HPP
 
-#include <list>
+#include <algorithm>
 #include <functional>
+#include <iterator>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include <mdlutils/types/sorted_list/list_backend.hpp>
+#include <mdlutils/types/sorted_list/indexed_list_backend.hpp>
+#include <mdlutils/types/sorted_list/flat_backend.hpp>
+#include <mdlutils/types/sorted_list/btree_backend.hpp>
 
 namespace mdl
 {
-    /* std::multiset-emulating class, utilizing std::list as a base container.
+    /* std::multiset-emulating class, keeping the elements in a sorted sequence container.
      * @T Type of the elements.
      * @Compare A binary predicate that takes two arguments of the same type as the elements and returns a bool.
-     * @Alloc Type of the allocator object used to define the storage allocation model.
+     * @Alloc Type of the allocator object used to define the storage allocation model. <arena_allocator> is
+     *  recommended for the node-based backends: each container (and each copy) gets an arena of its own, so the
+     *  nodes are packed together, reused without calling malloc/free, and released at once when the container is
+     *  cleared. A moved-to container shares the arena with the moved-from one, though (see <arena_allocator>), so
+     *  use <pool_allocator> instead for containers handed between threads.
+     * @Backend Policy selecting the underlying storage: <list_backend> (std::list, the default),
+     *  <indexed_list_backend> (std::list with a skip list index), <flat_backend> (sorted std::vector) or
+     *  <btree_backend> (B+-tree with cache-line-sized nodes).
+     *
+     * The storage keeps the elements ordered and implements the insertion, the bound lookups and the erasure; the
+     * rest of the interface is implemented on top of these. Equivalent elements are kept in the insertion order.
      */
-    template<typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>>
+    template<typename T, typename Compare = std::less<T>, typename Alloc = std::allocator<T>,
+            typename Backend = list_backend>
     class sorted_list
     {
     protected:
-        // The underlying container, std::list with Alloc as the allocator.
-        typedef std::list<T, Alloc> base_type;
+        // The underlying storage, selected by the Backend policy.
+        typedef typename Backend::template storage<T, Compare, Alloc> base_type;
         base_type base;
         Compare comp;
-        Alloc alloc;
 
     public:
         // The second template parameter.
@@ -39,6 +58,9 @@ namespace mdl
         // The third template parameter
         typedef Alloc allocator_type;
 
+        // The fourth template parameter
+        typedef Backend backend_type;
+
         // value_type&
         typedef T &reference;
         // const value_type&
@@ -49,14 +71,14 @@ namespace mdl
         // Const pointer type of the allocator_type.
         typedef typename std::allocator_traits<allocator_type>::pointer const_pointer;
 
-        // A bidirectional iterator to const value_type.
-        typedef typename base_type::const_iterator iterator;
-        // A bidirectional iterator to const value_type.
-        typedef typename base_type::const_iterator const_iterator;
+        // A bidirectional (or, for <flat_backend>, random access) iterator to const value_type.
+        typedef typename base_type::iterator iterator;
+        // A bidirectional (or, for <flat_backend>, random access) iterator to const value_type.
+        typedef typename base_type::iterator const_iterator;
         // A reverse iterator on <iterator>.
-        typedef typename base_type::const_reverse_iterator reverse_iterator;
+        typedef std::reverse_iterator<iterator> reverse_iterator;
         // A reverse iterator on <const_iterator>.
-        typedef typename base_type::const_reverse_iterator const_reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
         // A signed integral type representing the differences between the iterators.
         typedef typename std::iterator_traits<iterator>::difference_type difference_type;
@@ -95,7 +117,7 @@ namespace mdl
          */
         sorted_list(const key_compare &comp = key_compare(),
                     const allocator_type &alloc = allocator_type()) :
-                base(alloc), comp(comp), alloc(alloc) { }
+                base(comp, alloc), comp(comp) { }
 
         /* Initializer list constructor
          * @il An initializer_list automatically constructed from initializer list declarators.
@@ -105,11 +127,9 @@ namespace mdl
         sorted_list(std::initializer_list<value_type> il,
                     const key_compare &comp = key_compare(),
                     const allocator_type &alloc = allocator_type()) :
-                base(alloc), comp(comp), alloc(alloc)
+                base(comp, alloc), comp(comp)
         {
-            iterator it = begin();
-            for (auto a : il)
-                it = insert(it, std::move(a));
+            insert(il.begin(), il.end());
         }
 
         /* Constructs a container with elements coming from the range [first,last)
@@ -122,24 +142,20 @@ namespace mdl
         template<typename InputIterator>
         sorted_list(InputIterator first, InputIterator last,
                     const key_compare &comp = key_compare(),
-                    const allocator_type &alloc = allocator_type()) : base(comp, alloc), comp(comp), alloc(alloc)
+                    const allocator_type &alloc = allocator_type()) : base(comp, alloc), comp(comp)
         {
-            iterator it = begin();
-            for (; first != last; ++first)
-                it = insert(it, *first);
+            insert(first, last);
         }
 
         // Copy constructor
-        sorted_list(const sorted_list<T, Compare, Alloc> &x) :
+        sorted_list(const sorted_list &x) :
                 base(x.base),
-                comp(x.comp),
-                alloc(x.alloc) { }
+                comp(x.comp) { }
 
         // Move constructor
-        sorted_list(sorted_list<T, Compare, Alloc> &&x) :
+        sorted_list(sorted_list &&x) :
                 base(std::move(x.base)),
-                comp(std::move(x.comp)),
-                alloc(std::move(x.alloc)) { }
+                comp(std::move(x.comp)) { }
 
         /* Create and insert a new element.
          * @args the values to be passed to the constructor.
@@ -161,31 +177,7 @@ namespace mdl
         template<typename... Args>
         iterator emplace_hint(iterator position, Args &&... args)
         {
-            T object(args...);
-
-            iterator begin = base.begin(), end = base.end(), it = position;
-
-            if (begin == end) // if the container is empty
-                return base.insert(begin, std::move(object));
-
-            if (comp(base.back(), object)) // shortcut, if the element is greater than the last element in the list
-                return base.insert(end, std::move(object));
-            if (comp(object, base.front())) // shortcut, if the element is smaller than the first element in the list
-                return base.insert(begin, std::move(object));
-
-            if (comp(object, *it)) // the value is smaller than the hinted position, therefore insert it to the left:
-            {
-                for (; it != begin; --it)
-                    if (comp(*it, object)) break;
-                return base.insert(++it,
-                                   std::move(object)); // we need to insert at an element greater than the smaller one
-            }
-            else // the value is greater-or-equal than the hinted position, therefore insert it to the right:
-            {
-                for (; it != end; ++it)
-                    if (comp(object, *it)) break;
-                return base.insert(it, std::move(object));
-            }
+            return base.insert(position, T(args...));
         }
 
         /* Insert element
@@ -195,17 +187,7 @@ namespace mdl
          */
         iterator insert(const T &value)
         {
-            iterator it = base.begin(), end = base.end();
-
-            if (it == end) // if the container is empty
-                return base.insert(it, value);
-
-            if (comp(base.back(), value)) // shortcut, if the element is greater than the last element in the list
-                return base.insert(end, value);
-
-            for (; it != end; ++it)
-                if (comp(value, *it)) break;
-            return base.insert(it, value);
+            return base.insert(base.begin(), T(value));
         }
 
         /* Insert element, given an hinted position.
@@ -216,57 +198,45 @@ namespace mdl
          */
         iterator insert(iterator position, const T &value)
         {
-            iterator begin = base.begin(), end = base.end(), it = position;
-
-            if (begin == end) // if the container is empty
-                return base.insert(begin, value);
-
-            if (comp(base.back(), value)) // shortcut, if the element is greater than the last element in the list
-                return base.insert(end, value);
-            if (comp(value, base.front())) // shortcut, if the element is smaller than the first element in the list
-                return base.insert(begin, value);
-
-            if (comp(value, *it)) // the value is smaller than the hinted position, therefore insert it to the left:
-            {
-                for (; it != begin; --it)
-                    if (comp(*it, value)) break;
-                return base.insert(++it, value); // we need to insert at an element greater than the smaller one
-            }
-            else // the value is greater-or-equal than the hinted position, therefore insert it to the right:
-            {
-                for (; it != end; ++it)
-                    if (comp(value, *it)) break;
-                return base.insert(it, value);
-            }
+            return base.insert(position, T(value));
         }
 
         /* Insert range of elements
          * @first iterator specifying the first element in the inserting range
          * @last iterator specifying the element after the last in the inserting range
          *
-         * @return an iterator that points to the last inserted element.
+         * The elements are collected and sorted (unless they already are), then merged with the contents in a single
+         * pass, so that sorted input is appended in linear time. Inserted elements follow the equivalent ones already
+         * present, and keep their relative order.
+         *
+         * @return an iterator that points to the greatest inserted element, or end() if the range was empty.
          */
         template<typename InsertIterator>
         iterator insert(InsertIterator first, const InsertIterator last)
         {
-            return insert(base.begin(), first, last);
+            std::vector<T> batch(first, last);
+            if (batch.empty())
+                return base.end();
+            if (!std::is_sorted(batch.begin(), batch.end(), comp))
+                std::stable_sort(batch.begin(), batch.end(), comp);
+
+            T greatest = batch.back();
+            base.merge(std::move(batch));
+            return std::prev(base.upper_bound(greatest));
         }
 
 
         /* Insert range of elements, given a hinted position
-         * @position hinted position to consider while inserting.
+         * @position hinted position, unused since the range is merged as a whole (see <insert(first, last)>).
          * @first iterator specifying the first element in the inserting range.
          * @last iterator specifying the element after the last in the inserting range.
          *
-         * @return an iterator that points to the last inserted element.
+         * @return an iterator that points to the greatest inserted element, or end() if the range was empty.
          */
         template<typename InsertIterator>
         iterator insert(iterator position, InsertIterator first, const InsertIterator last)
         {
-            iterator it = position;
-            for (; first != last; ++first)
-                it = insert(it, *first);
-            return it;
+            return insert(first, last);
         }
 
         /* Searches the list for the first element equivalent to <value>
@@ -276,10 +246,7 @@ namespace mdl
          */
         iterator find(const T &value) const
         {
-            iterator begin = base.begin(), end = base.end(), it;
-
-            // To improve stability, just go from the beginning to the end:
-            for (it = begin; it != end && comp(*it, value); ++it); // go up, until you meet a value >= or end
+            iterator it = base.lower_bound(value), end = base.end();
             if (it != end && !comp(value, *it)) return it; // if the element is <= (and not end) return it
             return end; // otherwise not found
         }
@@ -291,30 +258,23 @@ namespace mdl
          */
         size_t count(const T &value) const
         {
-            iterator begin = find(value), end = base.end();
-            size_t c = 0;
-            for (; begin != end && equiv(begin, value); ++c, ++begin); // while not end and in the equivalence class
-            return c;
+            std::pair<iterator, iterator> range = equal_range(value);
+            return std::distance(range.first, range.second);
         }
 
-        /* Returns the iterator for the first element equivalent to value (equivalent to <find>)
+        /* Returns the iterator for the first element not smaller than value.
          * @value key of the element to search for.
          *
-         * @return valid iterator to the first element found, or end() if the element was not found.
+         * @return valid iterator to the first element not smaller than value, or end() if there is none.
          */
-        iterator lower_bound(const T &value) const { return find(value); }
+        iterator lower_bound(const T &value) const { return base.lower_bound(value); }
 
-        /* Returns the iterator for the first element after <lower_bound> not equivalent to value
+        /* Returns the iterator for the first element greater than value.
          * @value key of the element to search for.
          *
-         * @return valid iterator to the first element found after the equivalence class of value.
+         * @return valid iterator to the first element after the equivalence class of value, or end() if there is none.
          */
-        iterator upper_bound(const T &value) const
-        {
-            iterator begin = find(value), end = base.end();
-            for (; begin != end && equiv(begin, value); ++begin); // while not end and in the equivalence class
-            return begin;
-        }
+        iterator upper_bound(const T &value) const { return base.upper_bound(value); }
 
         /* Returns the bounds of a range that includes all the elements in the container that are equivalent to <value>.
          * @value key of the element to search for.
@@ -323,7 +283,7 @@ namespace mdl
          */
         std::pair<iterator, iterator> equal_range(const T &value) const
         {
-            iterator begin = find(value), end = base.end(), it = begin;
+            iterator begin = base.lower_bound(value), end = base.end(), it = begin;
             for (; it != end && equiv(it, value); ++it); // while not end and in the equivalence class
             return std::make_pair(begin, it);
         }
@@ -336,36 +296,19 @@ namespace mdl
          */
         size_t erase(iterator position, const T &value)
         {
-            if (base.empty()) // if the container is empty
-                return 0;
-            if (comp(base.back(), value)) // shortcut, if the element is greater than the last element in the list
-                return 0;
-            if (comp(value, base.front())) // shortcut, if the element is smaller than the first element in the list
-                return 0;
-
-            size_t removed = 0;
-            while (position != base.end() && equiv(position, value)) // '!( < || > )' <==> '==', shortcut if hinted == value
-            {
-                position = base.erase(position);
-                ++removed;
-            }
-
-            iterator begin = base.begin(), end = base.end(), it;
-
-            // To improve stability, just go from the it to the end, and/or from the beginning to the it:
-            for (it = position; it != end && comp(*it, value); ++it); // go up, until you meet a value >= or end
-            while (it != end && equiv(it, value)) // while not end and in the equivalence class
-            {
-                it = base.erase(it);
-                ++removed;
-            }
-            for (it = begin; it != position && comp(*it, value); ++it); // go up, until you meet a value >= or position
-            while (it != position && equiv(it, value)) // while not end and in the equivalence class
+            std::pair<iterator, iterator> range;
+            if (position != base.end() && equiv(position, value)) // shortcut, walk out of the hinted position
             {
-                it = base.erase(it);
-                ++removed;
+                iterator first = position, last = position, begin = base.begin(), end = base.end();
+                for (; first != begin && equiv(std::prev(first), value); --first);
+                for (; last != end && equiv(last, value); ++last);
+                range = std::make_pair(first, last);
             }
+            else
+                range = equal_range(value);
 
+            size_t removed = std::distance(range.first, range.second);
+            base.erase(range.first, range.second);
             return removed;
         }
 
@@ -376,7 +319,7 @@ namespace mdl
          */
         size_t erase(const T &value)
         {
-            return erase(base.begin(), value);
+            return erase(base.end(), value);
         }
 
         /* Erase element
@@ -394,26 +337,26 @@ namespace mdl
          */
         iterator erase(iterator first, iterator last) { return base.erase(first, last); }
 
-        /* Clears the underlying list container */
+        /* Clears the underlying container */
         void clear() { base.clear(); }
 
         /* Erases the last element from the list */
-        void pop_back() { base.pop_back(); }
+        void pop_back() { base.erase(std::prev(base.end())); }
 
         /* Erases the first element from the list */
-        void pop_front() { base.pop_front(); }
+        void pop_front() { base.erase(base.begin()); }
 
         /* Returns the last element of the list
          *
          * @return The last element of the list
          */
-        const T &back() const { return base.back(); }
+        const T &back() const { return *std::prev(base.end()); }
 
         /* Returns the first element of the list
          *
          * @return The first element of the list
          */
-        const T &front() const { return base.front(); }
+        const T &front() const { return *base.begin(); }
 
         /* Returns the number of elements in the list
          *
@@ -421,7 +364,7 @@ namespace mdl
          */
         size_t size() const { return base.size(); }
 
-        /* Checks, whether the underlying list container is empty
+        /* Checks, whether the underlying container is empty
          *
          * @return true if the list is empty, false otherwise
          */
@@ -429,11 +372,11 @@ namespace mdl
 
         /* Explicit conversion operator to std::list<T>
          *
-         * Returns the copy of the underlying list container
+         * Returns the copy of the elements, in order.
          */
         explicit operator std::list<T, Alloc>()
         {
-            return base;
+            return std::list<T, Alloc>(base.begin(), base.end(), base.get_allocator());
         };
 
         // Return an iterator to the first element of the sequence
@@ -449,28 +392,28 @@ namespace mdl
         const_iterator end() const { return base.end(); }
 
         // Return an iterator to the first element of the sequence
-        const_iterator cbegin() const { return base.cbegin(); }
+        const_iterator cbegin() const { return base.begin(); }
 
         // Return an iterator to the element after the last element of the sequence
-        const_iterator cend() const { return base.cend(); }
+        const_iterator cend() const { return base.end(); }
 
         // Return a reverse_iterator to the last element of the sequence
-        reverse_iterator rbegin() { return base.rbegin(); }
+        reverse_iterator rbegin() { return reverse_iterator(base.end()); }
 
         // Return the end() reverse_iterator of the sequence
-        reverse_iterator rend() { return base.rend(); }
+        reverse_iterator rend() { return reverse_iterator(base.begin()); }
 
         // Return a reverse_iterator to the last element of the sequence
-        const_reverse_iterator rbegin() const { return base.rbegin(); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(base.end()); }
 
         // Return the end() reverse_iterator of the sequence
-        const_reverse_iterator rend() const { return base.rend(); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(base.begin()); }
 
         // Return a reverse_iterator to the last element of the sequence
-        const_reverse_iterator crbegin() const { return base.crbegin(); }
+        const_reverse_iterator crbegin() const { return const_reverse_iterator(base.end()); }
 
         // Return the end() reverse_iterator of the sequence
-        const_reverse_iterator crend() const { return base.crend(); }
+        const_reverse_iterator crend() const { return const_reverse_iterator(base.begin()); }
 
         /* Returns a copy of the comparison object used by the container. */
         Compare key_comp() const { return comp; }
@@ -479,7 +422,7 @@ namespace mdl
         Compare value_comp() const { return comp; }
 
         /* Returns a copy of the allocator object used by the container. */
-        Alloc get_allocator() const { return alloc; }
+        Alloc get_allocator() const { return base.get_allocator(); }
 
         /* Returns the maximum number of elements that the container can hold */
         size_t max_size() const { return base.max_size(); }
@@ -490,13 +433,13 @@ namespace mdl
 // multiset comparison operators, require inclusion of set
 #include <set>
 
-template <class T, class Compare, class Allocator>
-bool operator== ( const mdl::sorted_list<T,Compare,Allocator>& lhs,
-                  const std::multiset<T,Compare,Allocator>& rhs )
+template <class T, class Compare, class Allocator, class Backend, class MultisetAllocator>
+bool operator== ( const mdl::sorted_list<T,Compare,Allocator,Backend>& lhs,
+                  const std::multiset<T,Compare,MultisetAllocator>& rhs )
 {
     Compare comp = lhs.key_comp();
     auto itl = lhs.begin(), lhs_end = lhs.end();
-    auto itr = rhs.begin(), rhs_end = rhs.end();
+    auto itr = rhs.begin();
     if(rhs.size() != lhs.size()) return false;
     for(; itl != lhs_end; ++itl, ++itr)
         if(comp(*itl, *itr) || comp(*itr, *itl))
@@ -504,23 +447,23 @@ bool operator== ( const mdl::sorted_list<T,Compare,Allocator>& lhs,
     return true;
 };
 
-template <class T, class Compare, class Allocator>
-bool operator!= ( const mdl::sorted_list<T,Compare,Allocator>& lhs,
-                  const std::multiset<T,Compare,Allocator>& rhs )
+template <class T, class Compare, class Allocator, class Backend, class MultisetAllocator>
+bool operator!= ( const mdl::sorted_list<T,Compare,Allocator,Backend>& lhs,
+                  const std::multiset<T,Compare,MultisetAllocator>& rhs )
 {
     return !(lhs == rhs);
 };
 
-template <class T, class Compare, class Allocator>
-bool operator== ( const std::multiset<T,Compare,Allocator>& lhs,
-                  const mdl::sorted_list<T,Compare,Allocator>& rhs )
+template <class T, class Compare, class Allocator, class Backend, class MultisetAllocator>
+bool operator== ( const std::multiset<T,Compare,MultisetAllocator>& lhs,
+                  const mdl::sorted_list<T,Compare,Allocator,Backend>& rhs )
 {
     return rhs == lhs;
 };
 
-template <class T, class Compare, class Allocator>
-bool operator!= ( const std::multiset<T,Compare,Allocator>& lhs,
-                  const mdl::sorted_list<T,Compare,Allocator>& rhs )
+template <class T, class Compare, class Allocator, class Backend, class MultisetAllocator>
+bool operator!= ( const std::multiset<T,Compare,MultisetAllocator>& lhs,
+                  const mdl::sorted_list<T,Compare,Allocator,Backend>& rhs )
 {
     return !(rhs == lhs);
 };
@@ -0,0 +1,746 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_TYPES_SORTED_LIST_BTREE_BACKEND_HPP
+#define MDLUTILS_TYPES_SORTED_LIST_BTREE_BACKEND_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Storage of <sorted_list> based on a B+-tree (see <btree_backend>).
+         * @T Type of the elements, has to be copy constructible and copy assignable (the inner nodes hold copies).
+         * @Compare Comparator defining the order of the elements.
+         * @Alloc Allocator, rebound to allocate the nodes of the tree.
+         * @NodeSize Size, in bytes, of the element (or key) array of a single node.
+         *
+         * The elements are stored in the leaves, which are linked for the iteration. Each inner node holds, for each
+         * but the first child, a separator key: a copy of an element not greater than the elements of that child, and
+         * not smaller than the elements of the preceding one. The separators are only updated when the nodes are
+         * split, merged or rebalanced, since erasing the elements does not invalidate the bounds.
+         */
+        template<typename T, typename Compare, typename Alloc, size_t NodeSize>
+        class btree_storage
+        {
+        protected:
+            static constexpr size_t leaf_capacity = NodeSize / sizeof(T) > 4 ? NodeSize / sizeof(T) : 4;
+            static constexpr size_t inner_capacity =
+                    NodeSize / (sizeof(T) + sizeof(void *)) > 4 ? NodeSize / (sizeof(T) + sizeof(void *)) : 4;
+            // Minimal number of elements of a non-root leaf, and of the children of a non-root inner node. The last
+            // leaf may hold fewer elements after appends, erasing from it rebalances it as usual.
+            static constexpr size_t leaf_min = leaf_capacity / 2;
+            static constexpr size_t inner_min = inner_capacity / 2;
+
+            typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot_t;
+
+            struct inner_node;
+
+            struct node_base
+            {
+                inner_node *parent;
+                bool is_leaf;
+            };
+
+            struct leaf_node : node_base
+            {
+                leaf_node *prev, *next;
+                size_t count;
+                slot_t slots[leaf_capacity];
+
+                T *values() { return reinterpret_cast<T *>(slots); }
+            };
+
+            struct inner_node : node_base
+            {
+                // Number of children; the keys [1, count) are constructed.
+                size_t count;
+                node_base *children[inner_capacity];
+                slot_t key_slots[inner_capacity];
+
+                T *keys() { return reinterpret_cast<T *>(key_slots); }
+            };
+
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<leaf_node> leaf_alloc_t;
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<inner_node> inner_alloc_t;
+            typedef std::allocator_traits<leaf_alloc_t> leaf_traits;
+            typedef std::allocator_traits<inner_alloc_t> inner_traits;
+
+            Compare comp;
+            leaf_alloc_t leaf_alloc;
+            inner_alloc_t inner_alloc;
+            node_base *root = nullptr;
+            leaf_node *first = nullptr, *last = nullptr;
+            size_t elements = 0;
+
+        public:
+            // A bidirectional iterator to const T, pointing to an element of a leaf (or to nullptr for the end).
+            class iterator
+            {
+                friend class btree_storage;
+
+                const btree_storage *tree;
+                leaf_node *leaf;
+                size_t index;
+
+                iterator(const btree_storage *tree, leaf_node *leaf, size_t index) :
+                        tree(tree), leaf(leaf), index(index) { }
+
+            public:
+                typedef std::bidirectional_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T *pointer;
+                typedef const T &reference;
+
+                iterator() : tree(nullptr), leaf(nullptr), index(0) { }
+
+                reference operator*() const { return leaf->values()[index]; }
+
+                pointer operator->() const { return leaf->values() + index; }
+
+                iterator &operator++()
+                {
+                    if (++index == leaf->count)
+                    {
+                        leaf = leaf->next;
+                        index = 0;
+                    }
+                    return *this;
+                }
+
+                iterator operator++(int)
+                {
+                    iterator copy = *this;
+                    ++*this;
+                    return copy;
+                }
+
+                iterator &operator--()
+                {
+                    if (!leaf)
+                    {
+                        leaf = tree->last;
+                        index = leaf->count - 1;
+                    }
+                    else if (index == 0)
+                    {
+                        leaf = leaf->prev;
+                        index = leaf->count - 1;
+                    }
+                    else
+                        --index;
+                    return *this;
+                }
+
+                iterator operator--(int)
+                {
+                    iterator copy = *this;
+                    --*this;
+                    return copy;
+                }
+
+                bool operator==(const iterator &other) const { return leaf == other.leaf && index == other.index; }
+
+                bool operator!=(const iterator &other) const { return !(*this == other); }
+            };
+
+        protected:
+            // Move [from, end) one slot to the right, leaving the slot at from unconstructed.
+            static void shift_right(T *array, size_t from, size_t end)
+            {
+                for (size_t k = end; k > from; --k)
+                {
+                    ::new(array + k) T(std::move(array[k - 1]));
+                    array[k - 1].~T();
+                }
+            }
+
+            // Move [from, end) one slot to the left, the slot at from - 1 has to be unconstructed.
+            static void shift_left(T *array, size_t from, size_t end)
+            {
+                for (size_t k = from; k < end; ++k)
+                {
+                    ::new(array + k - 1) T(std::move(array[k]));
+                    array[k].~T();
+                }
+            }
+
+            // Move n elements to unconstructed slots, leaving the source unconstructed.
+            static void move_slots(T *source, size_t n, T *destination)
+            {
+                for (size_t k = 0; k < n; ++k)
+                {
+                    ::new(destination + k) T(std::move(source[k]));
+                    source[k].~T();
+                }
+            }
+
+            static size_t child_index(inner_node *parent, node_base *child)
+            {
+                size_t index = 0;
+                while (parent->children[index] != child)
+                    ++index;
+                return index;
+            }
+
+            leaf_node *new_leaf()
+            {
+                leaf_node *leaf = leaf_traits::allocate(leaf_alloc, 1);
+                leaf->parent = nullptr;
+                leaf->is_leaf = true;
+                leaf->prev = leaf->next = nullptr;
+                leaf->count = 0;
+                return leaf;
+            }
+
+            inner_node *new_inner()
+            {
+                inner_node *inner = inner_traits::allocate(inner_alloc, 1);
+                inner->parent = nullptr;
+                inner->is_leaf = false;
+                inner->count = 0;
+                return inner;
+            }
+
+            void free_node(node_base *node)
+            {
+                if (node->is_leaf)
+                {
+                    leaf_node *leaf = static_cast<leaf_node *>(node);
+                    for (size_t k = 0; k < leaf->count; ++k)
+                        leaf->values()[k].~T();
+                    leaf_traits::deallocate(leaf_alloc, leaf, 1);
+                }
+                else
+                {
+                    inner_node *inner = static_cast<inner_node *>(node);
+                    for (size_t k = 1; k < inner->count; ++k)
+                        inner->keys()[k].~T();
+                    inner_traits::deallocate(inner_alloc, inner, 1);
+                }
+            }
+
+            void free_subtree(node_base *node)
+            {
+                if (!node->is_leaf)
+                {
+                    inner_node *inner = static_cast<inner_node *>(node);
+                    for (size_t k = 0; k < inner->count; ++k)
+                        free_subtree(inner->children[k]);
+                }
+                free_node(node);
+            }
+
+            /* Descend to the leaf which may hold the bound of the value.
+             * @Upper Whether to look for the upper (or the lower) bound.
+             * @index Set to the position of the bound in the leaf, possibly equal to the number of its elements.
+             */
+            template<bool Upper>
+            leaf_node *descend(const T &value, size_t &index) const
+            {
+                node_base *node = root;
+                while (!node->is_leaf)
+                {
+                    inner_node *inner = static_cast<inner_node *>(node);
+                    T *keys = inner->keys() + 1, *keys_end = inner->keys() + inner->count;
+                    T *bound = Upper ? std::upper_bound(keys, keys_end, value, comp)
+                                     : std::lower_bound(keys, keys_end, value, comp);
+                    node = inner->children[bound - keys];
+                }
+                leaf_node *leaf = static_cast<leaf_node *>(node);
+                T *values = leaf->values(), *values_end = leaf->values() + leaf->count;
+                T *bound = Upper ? std::upper_bound(values, values_end, value, comp)
+                                 : std::lower_bound(values, values_end, value, comp);
+                index = bound - values;
+                return leaf;
+            }
+
+            // Iterator to the position, moving to the next leaf if the position is past the last element of the leaf.
+            iterator make_iterator(leaf_node *leaf, size_t index) const
+            {
+                if (index == leaf->count)
+                    return iterator(this, leaf->next, 0);
+                return iterator(this, leaf, index);
+            }
+
+            // Set the separator bounding the node from the left (if there is one) to key.
+            void update_separator(node_base *node, const T &key)
+            {
+                for (; node->parent; node = node->parent)
+                {
+                    size_t index = child_index(node->parent, node);
+                    if (index > 0)
+                    {
+                        node->parent->keys()[index] = key;
+                        return;
+                    }
+                }
+            }
+
+            // Insert the child and its separator key at the position of the inner node, which has to have room.
+            static void insert_child_at(inner_node *inner, size_t index, const T &key, node_base *child)
+            {
+                shift_right(inner->keys(), index, inner->count);
+                ::new(inner->keys() + index) T(key);
+                std::copy_backward(inner->children + index, inner->children + inner->count,
+                                   inner->children + inner->count + 1);
+                inner->children[index] = child;
+                child->parent = inner;
+                ++inner->count;
+            }
+
+            // Remove the child and its separator key (index > 0) from the inner node.
+            static void remove_child_at(inner_node *inner, size_t index)
+            {
+                inner->keys()[index].~T();
+                shift_left(inner->keys(), index + 1, inner->count);
+                std::copy(inner->children + index + 1, inner->children + inner->count, inner->children + index);
+                --inner->count;
+            }
+
+            // Link the node, split from left, right after it, splitting the parents as needed.
+            void insert_child(node_base *left, node_base *right, const T &key)
+            {
+                inner_node *parent = left->parent;
+                if (!parent)
+                {
+                    parent = new_inner();
+                    parent->children[0] = left;
+                    parent->count = 1;
+                    left->parent = parent;
+                    root = parent;
+                }
+                size_t index = child_index(parent, left) + 1;
+                if (parent->count < inner_capacity)
+                {
+                    insert_child_at(parent, index, key, right);
+                    return;
+                }
+
+                // Split the parent, the children [half, count) are moved to the new node
+                const size_t half = inner_capacity / 2;
+                inner_node *sibling = new_inner();
+                T separator(std::move(parent->keys()[half]));
+                parent->keys()[half].~T();
+                move_slots(parent->keys() + half + 1, parent->count - half - 1, sibling->keys() + 1);
+                for (size_t k = half; k < parent->count; ++k)
+                {
+                    sibling->children[k - half] = parent->children[k];
+                    parent->children[k]->parent = sibling;
+                }
+                sibling->count = parent->count - half;
+                parent->count = half;
+
+                if (index > half)
+                    insert_child_at(sibling, index - half, key, right);
+                else
+                    insert_child_at(parent, index, key, right);
+                insert_child(parent, sibling, separator);
+            }
+
+            // Insert the value at the position of the leaf, splitting it if it is full.
+            iterator insert_at(leaf_node *leaf, size_t index, T &&value)
+            {
+                if (leaf->count == leaf_capacity && leaf == last && index == leaf->count)
+                {
+                    // Appending, so start a new leaf instead of splitting: sequential inserts leave the leaves full
+                    leaf_node *right = new_leaf();
+                    right->prev = leaf;
+                    leaf->next = right;
+                    last = right;
+                    insert_child(leaf, right, value);
+                    leaf = right;
+                    index = 0;
+                }
+                else if (leaf->count == leaf_capacity)
+                {
+                    const size_t half = leaf_capacity / 2;
+                    leaf_node *right = new_leaf();
+                    move_slots(leaf->values() + half, leaf->count - half, right->values());
+                    right->count = leaf->count - half;
+                    leaf->count = half;
+
+                    right->prev = leaf;
+                    right->next = leaf->next;
+                    if (leaf->next)
+                        leaf->next->prev = right;
+                    else
+                        last = right;
+                    leaf->next = right;
+                    insert_child(leaf, right, right->values()[0]);
+
+                    if (index > half)
+                    {
+                        index -= half;
+                        leaf = right;
+                    }
+                }
+
+                shift_right(leaf->values(), index, leaf->count);
+                ::new(leaf->values() + index) T(std::move(value));
+                ++leaf->count;
+                ++elements;
+                // The value may be smaller than the separator bounding the leaf, e.g. when inserted at a hint
+                if (index == 0 && leaf != first)
+                    update_separator(leaf, leaf->values()[0]);
+                return iterator(this, leaf, index);
+            }
+
+            // Unlink an empty leaf from the list of leaves and free it.
+            void unlink_leaf(leaf_node *leaf)
+            {
+                if (leaf->prev)
+                    leaf->prev->next = leaf->next;
+                else
+                    first = leaf->next;
+                if (leaf->next)
+                    leaf->next->prev = leaf->prev;
+                else
+                    last = leaf->prev;
+                free_node(leaf);
+            }
+
+            /* Refill a leaf that has fallen below the minimal size, borrowing from or merging with a sibling.
+             * @leaf The leaf, updated if it was merged into its left sibling.
+             * @index Tracked position in the leaf, updated along with it.
+             */
+            void rebalance_leaf(leaf_node *&leaf, size_t &index)
+            {
+                inner_node *parent = leaf->parent;
+                size_t position = child_index(parent, leaf);
+                leaf_node *left = position > 0 ? static_cast<leaf_node *>(parent->children[position - 1]) : nullptr;
+                leaf_node *right = position + 1 < parent->count ?
+                                   static_cast<leaf_node *>(parent->children[position + 1]) : nullptr;
+
+                if (left && left->count > leaf_min)
+                {
+                    shift_right(leaf->values(), 0, leaf->count);
+                    move_slots(left->values() + left->count - 1, 1, leaf->values());
+                    --left->count;
+                    ++leaf->count;
+                    ++index;
+                    parent->keys()[position] = leaf->values()[0];
+                }
+                else if (right && right->count > leaf_min)
+                {
+                    move_slots(right->values(), 1, leaf->values() + leaf->count);
+                    shift_left(right->values(), 1, right->count);
+                    --right->count;
+                    ++leaf->count;
+                    parent->keys()[position + 1] = right->values()[0];
+                }
+                else if (left)
+                {
+                    move_slots(leaf->values(), leaf->count, left->values() + left->count);
+                    index += left->count;
+                    left->count += leaf->count;
+                    leaf->count = 0;
+                    unlink_leaf(leaf);
+                    remove_child_at(parent, position);
+                    leaf = left;
+                    rebalance_inner(parent);
+                }
+                else
+                {
+                    move_slots(right->values(), right->count, leaf->values() + leaf->count);
+                    leaf->count += right->count;
+                    right->count = 0;
+                    unlink_leaf(right);
+                    remove_child_at(parent, position + 1);
+                    rebalance_inner(parent);
+                }
+            }
+
+            // Move the children of source (with the separator key in front of them) to the end of destination.
+            static void append_children(inner_node *destination, const T &key, inner_node *source)
+            {
+                ::new(destination->keys() + destination->count) T(key);
+                move_slots(source->keys() + 1, source->count - 1, destination->keys() + destination->count + 1);
+                for (size_t k = 0; k < source->count; ++k)
+                {
+                    destination->children[destination->count + k] = source->children[k];
+                    source->children[k]->parent = destination;
+                }
+                destination->count += source->count;
+                source->count = 0;
+            }
+
+            // Refill an inner node that has fallen below the minimal size, or shrink the tree at the root.
+            void rebalance_inner(inner_node *inner)
+            {
+                if (inner == root)
+                {
+                    if (inner->count == 1)
+                    {
+                        root = inner->children[0];
+                        root->parent = nullptr;
+                        free_node(inner);
+                    }
+                    return;
+                }
+                if (inner->count >= inner_min)
+                    return;
+
+                inner_node *parent = inner->parent;
+                size_t position = child_index(parent, inner);
+                inner_node *left = position > 0 ? static_cast<inner_node *>(parent->children[position - 1]) : nullptr;
+                inner_node *right = position + 1 < parent->count ?
+                                    static_cast<inner_node *>(parent->children[position + 1]) : nullptr;
+
+                if (left && left->count > inner_min)
+                {
+                    // The last child of left becomes the first child of inner
+                    node_base *child = left->children[left->count - 1];
+                    shift_right(inner->keys(), 1, inner->count);
+                    ::new(inner->keys() + 1) T(parent->keys()[position]);
+                    std::copy_backward(inner->children, inner->children + inner->count,
+                                       inner->children + inner->count + 1);
+                    inner->children[0] = child;
+                    child->parent = inner;
+                    ++inner->count;
+                    parent->keys()[position] = std::move(left->keys()[left->count - 1]);
+                    left->keys()[left->count - 1].~T();
+                    --left->count;
+                }
+                else if (right && right->count > inner_min)
+                {
+                    // The first child of right becomes the last child of inner
+                    node_base *child = right->children[0];
+                    ::new(inner->keys() + inner->count) T(parent->keys()[position + 1]);
+                    inner->children[inner->count] = child;
+                    child->parent = inner;
+                    ++inner->count;
+                    parent->keys()[position + 1] = std::move(right->keys()[1]);
+                    right->keys()[1].~T();
+                    shift_left(right->keys(), 2, right->count);
+                    std::copy(right->children + 1, right->children + right->count, right->children);
+                    --right->count;
+                }
+                else if (left)
+                {
+                    append_children(left, parent->keys()[position], inner);
+                    free_node(inner);
+                    remove_child_at(parent, position);
+                    rebalance_inner(parent);
+                }
+                else
+                {
+                    append_children(inner, parent->keys()[position + 1], right);
+                    free_node(right);
+                    remove_child_at(parent, position + 1);
+                    rebalance_inner(parent);
+                }
+            }
+
+        public:
+            btree_storage(const Compare &comp, const Alloc &alloc) :
+                    comp(comp), leaf_alloc(alloc), inner_alloc(alloc) { }
+
+            btree_storage(const btree_storage &other) :
+                    comp(other.comp), leaf_alloc(leaf_traits::select_on_container_copy_construction(other.leaf_alloc)),
+                    inner_alloc(leaf_alloc)
+            {
+                for (const T &value : other)
+                    insert(end(), T(value));
+            }
+
+            btree_storage(btree_storage &&other) :
+                    comp(std::move(other.comp)), leaf_alloc(std::move(other.leaf_alloc)),
+                    inner_alloc(std::move(other.inner_alloc)),
+                    root(other.root), first(other.first), last(other.last), elements(other.elements)
+            {
+                other.root = nullptr;
+                other.first = other.last = nullptr;
+                other.elements = 0;
+            }
+
+            btree_storage &operator=(btree_storage other)
+            {
+                swap(other);
+                return *this;
+            }
+
+            ~btree_storage() { clear(); }
+
+            void swap(btree_storage &other)
+            {
+                using std::swap;
+                swap(comp, other.comp);
+                swap(leaf_alloc, other.leaf_alloc);
+                swap(inner_alloc, other.inner_alloc);
+                swap(root, other.root);
+                swap(first, other.first);
+                swap(last, other.last);
+                swap(elements, other.elements);
+            }
+
+            iterator begin() const { return iterator(this, first, 0); }
+
+            iterator end() const { return iterator(this, nullptr, 0); }
+
+            size_t size() const { return elements; }
+
+            bool empty() const { return elements == 0; }
+
+            size_t max_size() const { return std::numeric_limits<size_t>::max() / sizeof(T); }
+
+            Alloc get_allocator() const { return Alloc(leaf_alloc); }
+
+            void clear()
+            {
+                if (root)
+                    free_subtree(root);
+                root = nullptr;
+                first = last = nullptr;
+                elements = 0;
+            }
+
+            /* Insert the value after the elements equivalent to it.
+             * @position Hinted position, used as is if the value belongs right before it (e.g. end() for appends).
+             * @value The value to insert.
+             *
+             * @return Iterator to the inserted element.
+             */
+            iterator insert(iterator position, T &&value)
+            {
+                if (!root)
+                {
+                    root = first = last = new_leaf();
+                    return insert_at(last, 0, std::move(value));
+                }
+
+                bool fits = (position == begin() || !comp(value, *std::prev(position))) &&
+                            (position == end() || comp(value, *position));
+                if (fits)
+                {
+                    if (position.leaf)
+                        return insert_at(position.leaf, position.index, std::move(value));
+                    return insert_at(last, last->count, std::move(value));
+                }
+
+                size_t index;
+                leaf_node *leaf = descend<true>(value, index);
+                return insert_at(leaf, index, std::move(value));
+            }
+
+            /* Merge a sorted batch of values into the tree, after the elements equivalent to them.
+             * @sorted The values, sorted with the comparator of the tree.
+             *
+             * Appends the values in O(m) if they are not smaller than the last element. Otherwise inserts them one by
+             * one in O(m log n) if the batch is small, or rebuilds the tree from the merged sequence in O(n + m).
+             */
+            void merge(std::vector<T> &&sorted)
+            {
+                if (elements > 0 && comp(sorted.front(), last->values()[last->count - 1]))
+                {
+                    if (sorted.size() < elements / 8)
+                    {
+                        for (T &value : sorted)
+                        {
+                            size_t index;
+                            leaf_node *leaf = descend<true>(value, index);
+                            insert_at(leaf, index, std::move(value));
+                        }
+                        return;
+                    }
+
+                    std::vector<T> existing;
+                    existing.reserve(elements);
+                    for (leaf_node *leaf = first; leaf; leaf = leaf->next)
+                        for (size_t k = 0; k < leaf->count; ++k)
+                            existing.push_back(std::move(leaf->values()[k]));
+                    clear();
+
+                    std::vector<T> merged;
+                    merged.reserve(existing.size() + sorted.size());
+                    std::merge(std::make_move_iterator(existing.begin()), std::make_move_iterator(existing.end()),
+                               std::make_move_iterator(sorted.begin()), std::make_move_iterator(sorted.end()),
+                               std::back_inserter(merged), comp);
+                    sorted.swap(merged);
+                }
+
+                for (T &value : sorted)
+                {
+                    if (!root)
+                        root = first = last = new_leaf();
+                    insert_at(last, last->count, std::move(value));
+                }
+            }
+
+            iterator lower_bound(const T &value) const
+            {
+                if (!root)
+                    return end();
+                size_t index;
+                leaf_node *leaf = descend<false>(value, index);
+                return make_iterator(leaf, index);
+            }
+
+            iterator upper_bound(const T &value) const
+            {
+                if (!root)
+                    return end();
+                size_t index;
+                leaf_node *leaf = descend<true>(value, index);
+                return make_iterator(leaf, index);
+            }
+
+            iterator erase(iterator position)
+            {
+                leaf_node *leaf = position.leaf;
+                size_t index = position.index;
+                leaf->values()[index].~T();
+                shift_left(leaf->values(), index + 1, leaf->count);
+                --leaf->count;
+                --elements;
+
+                if (leaf == root)
+                {
+                    if (leaf->count == 0)
+                    {
+                        clear();
+                        return end();
+                    }
+                }
+                else if (leaf->count < leaf_min)
+                    rebalance_leaf(leaf, index);
+                return make_iterator(leaf, index);
+            }
+
+            iterator erase(iterator first, iterator last)
+            {
+                // Erasing may move the elements between the leaves, so count them upfront
+                for (std::ptrdiff_t n = std::distance(first, last); n > 0; --n)
+                    first = erase(first);
+                return first;
+            }
+        };
+    }
+
+    /* Backend policy of <sorted_list>, storing the elements in a B+-tree.
+     * @NodeSize Size, in bytes, of the element array of a single node; by default four cache lines, so that a node
+     *  is searched with a few cache misses, while the tree stays shallow.
+     *
+     * O(log n) lookups, inserts and erasures. Inserting and erasing invalidates the iterators to the elements of
+     * the affected leaves.
+     */
+    template<size_t NodeSize = 256>
+    struct btree_backend
+    {
+        template<typename T, typename Compare, typename Alloc>
+        using storage = helper::btree_storage<T, Compare, Alloc, NodeSize>;
+    };
+}
+
+#endif //MDLUTILS_TYPES_SORTED_LIST_BTREE_BACKEND_HPP
@@ -0,0 +1,103 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_TYPES_SORTED_LIST_FLAT_BACKEND_HPP
+#define MDLUTILS_TYPES_SORTED_LIST_FLAT_BACKEND_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Storage of <sorted_list> based on a sorted std::vector (see <flat_backend>).
+         * @T Type of the elements.
+         * @Compare Comparator defining the order of the elements.
+         * @Alloc Allocator used for the vector.
+         *
+         * Lookups are binary searches over contiguous memory; inserting and erasing shift the tail of the vector.
+         */
+        template<typename T, typename Compare, typename Alloc>
+        class flat_storage
+        {
+        protected:
+            typedef std::vector<T, Alloc> base_type;
+            base_type base;
+            Compare comp;
+
+        public:
+            // A random access iterator to const T.
+            typedef typename base_type::const_iterator iterator;
+
+            flat_storage(const Compare &comp, const Alloc &alloc) : base(alloc), comp(comp) { }
+
+            iterator begin() const { return base.begin(); }
+
+            iterator end() const { return base.end(); }
+
+            size_t size() const { return base.size(); }
+
+            bool empty() const { return base.empty(); }
+
+            size_t max_size() const { return base.max_size(); }
+
+            Alloc get_allocator() const { return base.get_allocator(); }
+
+            void clear() { base.clear(); }
+
+            /* Insert the value after the elements equivalent to it.
+             * @position Hinted position, used as is if the value belongs right before it (e.g. end() for appends).
+             * @value The value to insert.
+             *
+             * @return Iterator to the inserted element.
+             */
+            iterator insert(iterator position, T &&value)
+            {
+                iterator begin = base.begin(), end = base.end();
+                bool fits = (position == begin || !comp(value, *(position - 1))) &&
+                            (position == end || comp(value, *position));
+                if (!fits)
+                    position = upper_bound(value);
+                return base.insert(position, std::move(value));
+            }
+
+            /* Merge a sorted batch of values into the vector, after the elements equivalent to them.
+             * @sorted The values, sorted with the comparator of the vector.
+             *
+             * Appends the values, then merges the two sorted runs in place in O(n + m), if needed.
+             */
+            void merge(std::vector<T> &&sorted)
+            {
+                size_t middle = base.size();
+                base.insert(base.end(), std::make_move_iterator(sorted.begin()), std::make_move_iterator(sorted.end()));
+                if (middle > 0 && comp(base[middle], base[middle - 1]))
+                    std::inplace_merge(base.begin(), base.begin() + middle, base.end(), comp);
+            }
+
+            iterator lower_bound(const T &value) const { return std::lower_bound(base.begin(), base.end(), value, comp); }
+
+            iterator upper_bound(const T &value) const { return std::upper_bound(base.begin(), base.end(), value, comp); }
+
+            iterator erase(iterator position) { return base.erase(position); }
+
+            iterator erase(iterator first, iterator last) { return base.erase(first, last); }
+        };
+    }
+
+    /* Backend policy of <sorted_list>, storing the elements in a sorted std::vector.
+     *
+     * O(log n) lookups with no pointer chasing, O(n) inserts and erasures (block shifts), which is the best fit
+     * for indexes that are mostly read. Inserting and erasing invalidates the iterators past the position.
+     */
+    struct flat_backend
+    {
+        template<typename T, typename Compare, typename Alloc>
+        using storage = helper::flat_storage<T, Compare, Alloc>;
+    };
+}
+
+#endif //MDLUTILS_TYPES_SORTED_LIST_FLAT_BACKEND_HPP
@@ -0,0 +1,407 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_TYPES_SORTED_LIST_INDEXED_LIST_BACKEND_HPP
+#define MDLUTILS_TYPES_SORTED_LIST_INDEXED_LIST_BACKEND_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Storage of <sorted_list> based on std::list, with a skip list index over its nodes (see
+         * <indexed_list_backend>).
+         * @T Type of the elements.
+         * @Compare Comparator defining the order of the elements.
+         * @Alloc Allocator, rebound to allocate the list nodes and the towers of the index.
+         *
+         * About one in <promotion> elements gets a tower of express lanes, linking it to the next tower of at least
+         * the same height; the heights are geometrically distributed. A lookup descends the lanes to the last tower
+         * before the bound, then scans the list from there, over <promotion> elements on average. Each list node
+         * points to its tower (if it has one), so that erasing an element unlinks the tower in O(log n).
+         */
+        template<typename T, typename Compare, typename Alloc>
+        class indexed_list_storage
+        {
+        protected:
+            // Maximal height of a tower, enough for about promotion^max_levels elements.
+            static constexpr size_t max_levels = 16;
+            // One in promotion towers is promoted to the next level (and one in promotion elements gets one).
+            static constexpr unsigned promotion = 4;
+
+            struct tower;
+
+            struct node
+            {
+                T value;
+                tower *index;
+
+                node(T &&value) : value(std::move(value)), index(nullptr) { }
+
+                node(const node &other) : value(other.value), index(nullptr) { }
+
+                node(node &&other) : value(std::move(other.value)), index(nullptr) { }
+            };
+
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<node> node_alloc_t;
+            typedef std::list<node, node_alloc_t> base_type;
+            typedef typename base_type::const_iterator base_iterator;
+
+            // Tower of an element, allocated with room for <height> links.
+            struct tower
+            {
+                base_iterator element;
+                size_t height;
+                tower *next[1];
+            };
+
+            typedef typename std::allocator_traits<Alloc>::template rebind_alloc<tower *> link_alloc_t;
+            typedef std::allocator_traits<link_alloc_t> link_traits;
+
+            base_type base;
+            Compare comp;
+            link_alloc_t link_alloc;
+            // Links of the head of the index, nullptr stands for the head in the tower pointers.
+            tower *head[max_levels] = {};
+            size_t levels = 0;
+            uint64_t random_state = 0x9E3779B97F4A7C15ull;
+
+        public:
+            // A bidirectional iterator to const T, stable until the element is erased.
+            class iterator
+            {
+                friend class indexed_list_storage;
+
+                base_iterator it;
+
+                explicit iterator(base_iterator it) : it(it) { }
+
+            public:
+                typedef std::bidirectional_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const T *pointer;
+                typedef const T &reference;
+
+                iterator() { }
+
+                reference operator*() const { return it->value; }
+
+                pointer operator->() const { return &it->value; }
+
+                iterator &operator++()
+                {
+                    ++it;
+                    return *this;
+                }
+
+                iterator operator++(int) { return iterator(it++); }
+
+                iterator &operator--()
+                {
+                    --it;
+                    return *this;
+                }
+
+                iterator operator--(int) { return iterator(it--); }
+
+                bool operator==(const iterator &other) const { return it == other.it; }
+
+                bool operator!=(const iterator &other) const { return it != other.it; }
+            };
+
+        protected:
+            static size_t words_for(size_t height)
+            {
+                return (sizeof(tower) + (height - 1) * sizeof(tower *) + sizeof(tower *) - 1) / sizeof(tower *);
+            }
+
+            tower *new_tower(base_iterator element, size_t height)
+            {
+                tower *t = ::new(static_cast<void *>(link_traits::allocate(link_alloc, words_for(height)))) tower;
+                t->element = element;
+                t->height = height;
+                return t;
+            }
+
+            void free_tower(tower *t)
+            {
+                size_t words = words_for(t->height);
+                t->~tower();
+                link_traits::deallocate(link_alloc, reinterpret_cast<tower **>(t), words);
+            }
+
+            // The links of the tower, or of the head for nullptr.
+            tower **links(tower *t) { return t ? t->next : head; }
+
+            tower *const *links(tower *t) const { return t ? t->next : head; }
+
+            // Height of a new tower, 0 for most of the elements (xorshift64*, the index needs no better randomness).
+            size_t random_height()
+            {
+                random_state ^= random_state >> 12;
+                random_state ^= random_state << 25;
+                random_state ^= random_state >> 27;
+                uint64_t bits = random_state * 0x2545F4914F6CDD1Dull;
+                size_t height = 0;
+                for (; height < max_levels && bits % promotion == 0; bits /= promotion)
+                    ++height;
+                return height;
+            }
+
+            /* Find the last tower, on each level, before the bound of the value.
+             * @upper Whether to look for the towers not greater than the value (or smaller than the value).
+             * @update If not nullptr, filled with the towers for each of the <levels>.
+             *
+             * @return The last such tower on the lowest level, or nullptr if there is none.
+             */
+            tower *predecessors(const T &value, bool upper, tower **update) const
+            {
+                tower *t = nullptr;
+                for (size_t level = levels; level-- > 0;)
+                {
+                    for (tower *next = links(t)[level]; next; next = links(t)[level])
+                    {
+                        const T &element = next->element->value;
+                        if (upper ? comp(value, element) : !comp(element, value))
+                            break;
+                        t = next;
+                    }
+                    if (update)
+                        update[level] = t;
+                }
+                return t;
+            }
+
+            // Give the (just inserted) element a tower of the given height, after the towers not greater than it.
+            void link_tower(typename base_type::iterator element, size_t height)
+            {
+                tower *update[max_levels];
+                predecessors(element->value, true, update);
+                for (; levels < height; ++levels)
+                    update[levels] = nullptr;
+
+                tower *t = new_tower(element, height);
+                element->index = t;
+                for (size_t level = 0; level < height; ++level)
+                {
+                    tower **previous = links(update[level]);
+                    t->next[level] = previous[level];
+                    previous[level] = t;
+                }
+            }
+
+            void unlink_tower(tower *t)
+            {
+                tower *update[max_levels];
+                predecessors(t->element->value, false, update);
+                for (size_t level = 0; level < t->height; ++level)
+                {
+                    // Skip the towers of the equivalent elements preceding the element
+                    tower *previous = update[level];
+                    while (links(previous)[level] != t)
+                        previous = links(previous)[level];
+                    links(previous)[level] = t->next[level];
+                }
+                free_tower(t);
+            }
+
+            void clear_index()
+            {
+                for (tower *t = head[0]; t;)
+                {
+                    tower *next = t->next[0];
+                    free_tower(t);
+                    t = next;
+                }
+                std::fill(head, head + max_levels, nullptr);
+                levels = 0;
+            }
+
+            // Drop the index and build a new one with a single pass over the list, in O(n).
+            void rebuild_index()
+            {
+                clear_index();
+                tower *tails[max_levels] = {};
+                for (auto it = base.begin(), end = base.end(); it != end; ++it)
+                {
+                    it->index = nullptr;
+                    size_t height = random_height();
+                    if (height == 0)
+                        continue;
+
+                    tower *t = new_tower(it, height);
+                    it->index = t;
+                    for (size_t level = 0; level < height; ++level)
+                    {
+                        t->next[level] = nullptr;
+                        links(tails[level])[level] = t;
+                        tails[level] = t;
+                    }
+                    if (height > levels)
+                        levels = height;
+                }
+            }
+
+        public:
+            indexed_list_storage(const Compare &comp, const Alloc &alloc) :
+                    base(node_alloc_t(alloc)), comp(comp), link_alloc(alloc) { }
+
+            indexed_list_storage(const indexed_list_storage &other) :
+                    base(other.base), comp(other.comp), link_alloc(base.get_allocator())
+            {
+                rebuild_index();
+            }
+
+            indexed_list_storage(indexed_list_storage &&other) :
+                    base(std::move(other.base)), comp(std::move(other.comp)),
+                    link_alloc(std::move(other.link_alloc)), levels(other.levels)
+            {
+                // The nodes, and therefore the iterators held by the towers, are taken over along with the list
+                std::copy(other.head, other.head + max_levels, head);
+                std::fill(other.head, other.head + max_levels, nullptr);
+                other.levels = 0;
+                other.base.clear();
+            }
+
+            indexed_list_storage &operator=(indexed_list_storage other)
+            {
+                swap(other);
+                return *this;
+            }
+
+            ~indexed_list_storage() { clear_index(); }
+
+            void swap(indexed_list_storage &other)
+            {
+                using std::swap;
+                swap(base, other.base);
+                swap(comp, other.comp);
+                swap(link_alloc, other.link_alloc);
+                swap(head, other.head);
+                swap(levels, other.levels);
+                swap(random_state, other.random_state);
+            }
+
+            iterator begin() const { return iterator(base.begin()); }
+
+            iterator end() const { return iterator(base.end()); }
+
+            size_t size() const { return base.size(); }
+
+            bool empty() const { return base.empty(); }
+
+            size_t max_size() const { return base.max_size(); }
+
+            Alloc get_allocator() const { return Alloc(base.get_allocator()); }
+
+            void clear()
+            {
+                clear_index();
+                base.clear();
+            }
+
+            /* Insert the value after the elements equivalent to it.
+             * @position Hinted position, used as is if the value belongs right before it (e.g. end() for appends).
+             * @value The value to insert.
+             *
+             * @return Iterator to the inserted element.
+             */
+            iterator insert(iterator position, T &&value)
+            {
+                base_iterator it = position.it;
+                bool fits = (it == base.begin() || !comp(value, std::prev(it)->value)) &&
+                            (it == base.end() || comp(value, it->value));
+                if (!fits)
+                    it = upper_bound(value).it;
+
+                typename base_type::iterator inserted = base.insert(it, node(std::move(value)));
+                size_t height = random_height();
+                if (height > 0)
+                    link_tower(inserted, height);
+                return iterator(inserted);
+            }
+
+            /* Merge a sorted batch of values into the list, after the elements equivalent to them.
+             * @sorted The values, sorted with the comparator of the list.
+             *
+             * Inserts the values one by one if the batch is small, otherwise splices or merges the nodes in O(n + m)
+             * and rebuilds the index.
+             */
+            void merge(std::vector<T> &&sorted)
+            {
+                if (sorted.size() < base.size() / 8)
+                {
+                    for (T &value : sorted)
+                        insert(end(), std::move(value));
+                    return;
+                }
+
+                base_type batch(base.get_allocator());
+                for (T &value : sorted)
+                    batch.emplace_back(std::move(value));
+                if (base.empty() || !comp(batch.front().value, base.back().value))
+                    base.splice(base.end(), batch);
+                else
+                {
+                    const Compare &comp = this->comp;
+                    base.merge(batch, [&comp](const node &a, const node &b) { return comp(a.value, b.value); });
+                }
+                rebuild_index();
+            }
+
+            iterator lower_bound(const T &value) const
+            {
+                tower *t = predecessors(value, false, nullptr);
+                base_iterator it = t ? t->element : base.begin(), end = base.end();
+                for (; it != end && comp(it->value, value); ++it);
+                return iterator(it);
+            }
+
+            iterator upper_bound(const T &value) const
+            {
+                tower *t = predecessors(value, true, nullptr);
+                base_iterator it = t ? t->element : base.begin(), end = base.end();
+                for (; it != end && !comp(value, it->value); ++it);
+                return iterator(it);
+            }
+
+            iterator erase(iterator position)
+            {
+                if (position.it->index)
+                    unlink_tower(position.it->index);
+                return iterator(base.erase(position.it));
+            }
+
+            iterator erase(iterator first, iterator last)
+            {
+                while (first != last)
+                    first = erase(first);
+                return last;
+            }
+        };
+    }
+
+    /* Backend policy of <sorted_list>, storing the elements in a std::list indexed with a skip list.
+     *
+     * O(log n) expected lookups and inserts, while the iterators stay valid until the element is erased, as with
+     * <list_backend>. The index costs a tower for about one in four elements, and a pointer per element.
+     */
+    struct indexed_list_backend
+    {
+        template<typename T, typename Compare, typename Alloc>
+        using storage = helper::indexed_list_storage<T, Compare, Alloc>;
+    };
+}
+
+#endif //MDLUTILS_TYPES_SORTED_LIST_INDEXED_LIST_BACKEND_HPP
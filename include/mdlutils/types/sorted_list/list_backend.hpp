@@ -0,0 +1,138 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#ifndef MDLUTILS_TYPES_SORTED_LIST_LIST_BACKEND_HPP
+#define MDLUTILS_TYPES_SORTED_LIST_LIST_BACKEND_HPP
+
+#include <iterator>
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace mdl
+{
+    namespace helper
+    {
+        /* Storage of <sorted_list> based on std::list (see <list_backend>).
+         * @T Type of the elements.
+         * @Compare Comparator defining the order of the elements.
+         * @Alloc Allocator used for the nodes of the list.
+         *
+         * All lookups are linear scans, but the iterators stay valid until the element is erased, and inserting
+         * next to a good hint takes a few comparisons.
+         */
+        template<typename T, typename Compare, typename Alloc>
+        class list_storage
+        {
+        protected:
+            typedef std::list<T, Alloc> base_type;
+            base_type base;
+            Compare comp;
+
+        public:
+            // A bidirectional iterator to const T.
+            typedef typename base_type::const_iterator iterator;
+
+            list_storage(const Compare &comp, const Alloc &alloc) : base(alloc), comp(comp) { }
+
+            iterator begin() const { return base.begin(); }
+
+            iterator end() const { return base.end(); }
+
+            size_t size() const { return base.size(); }
+
+            bool empty() const { return base.empty(); }
+
+            size_t max_size() const { return base.max_size(); }
+
+            Alloc get_allocator() const { return Alloc(base.get_allocator()); }
+
+            void clear() { base.clear(); }
+
+            /* Insert the value after the elements equivalent to it, walking from the hinted position.
+             * @position Hinted position to consider while inserting.
+             * @value The value to insert.
+             *
+             * @return Iterator to the inserted element.
+             */
+            iterator insert(iterator position, T &&value)
+            {
+                iterator begin = base.begin(), end = base.end(), it = position;
+
+                if (begin == end) // if the container is empty
+                    return base.insert(begin, std::move(value));
+
+                if (comp(base.back(), value)) // shortcut, if the element is greater than the last element in the list
+                    return base.insert(end, std::move(value));
+                if (comp(value, base.front())) // shortcut, if the element is smaller than the first element in the list
+                    return base.insert(begin, std::move(value));
+
+                if (it == end) // the value is not greater than the last element, so start from there
+                    --it;
+                if (comp(value, *it)) // the value is smaller than the hinted position, therefore insert it to the left:
+                {
+                    for (; it != begin; --it)
+                        if (!comp(value, *it)) break;
+                    return base.insert(++it, std::move(value)); // insert right after the last not greater element
+                }
+                else // the value is greater-or-equal than the hinted position, therefore insert it to the right:
+                {
+                    for (; it != end; ++it)
+                        if (comp(value, *it)) break;
+                    return base.insert(it, std::move(value));
+                }
+            }
+
+            /* Merge a sorted batch of values into the list, after the elements equivalent to them.
+             * @sorted The values, sorted with the comparator of the list.
+             *
+             * Appends the values in O(m) if they are not smaller than the last element, merges in O(n + m) otherwise.
+             */
+            void merge(std::vector<T> &&sorted)
+            {
+                if (base.empty() || !comp(sorted.front(), base.back()))
+                {
+                    base.insert(base.end(), std::make_move_iterator(sorted.begin()),
+                                std::make_move_iterator(sorted.end()));
+                    return;
+                }
+                base_type batch(std::make_move_iterator(sorted.begin()), std::make_move_iterator(sorted.end()),
+                                base.get_allocator());
+                base.merge(batch, comp);
+            }
+
+            // The first element not smaller than value, found with a linear scan.
+            iterator lower_bound(const T &value) const
+            {
+                iterator it = base.begin(), end = base.end();
+                for (; it != end && comp(*it, value); ++it);
+                return it;
+            }
+
+            // The first element greater than value, found with a linear scan.
+            iterator upper_bound(const T &value) const
+            {
+                iterator it = lower_bound(value), end = base.end();
+                for (; it != end && !comp(value, *it); ++it);
+                return it;
+            }
+
+            iterator erase(iterator position) { return base.erase(position); }
+
+            iterator erase(iterator first, iterator last) { return base.erase(first, last); }
+        };
+    }
+
+    /* Backend policy of <sorted_list>, storing the elements in a std::list.
+     *
+     * The default, for compatibility: O(n) lookups, but stable iterators and O(1) erasure.
+     */
+    struct list_backend
+    {
+        template<typename T, typename Compare, typename Alloc>
+        using storage = helper::list_storage<T, Compare, Alloc>;
+    };
+}
+
+#endif //MDLUTILS_TYPES_SORTED_LIST_LIST_BACKEND_HPP
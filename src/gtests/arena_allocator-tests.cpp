@@ -0,0 +1,136 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <vector>
+#include <list>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/memory/arena_allocator.hpp>
+#include <mdlutils/types/range.hpp>
+#include <mdlutils/types/sorted_list.hpp>
+
+TEST(ArenaAllocatorTest, AlignedAndDistinct)
+{
+    mdl::arena_allocator<int> alloc;
+    std::vector<int *> blocks;
+    for (int i : mdl::range<int>(10000))
+    {
+        int *p = alloc.allocate(1);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % mdl::arena::block_alignment);
+        *p = i;
+        blocks.push_back(p);
+    }
+    for (int i : mdl::range<int>(10000))
+        EXPECT_EQ(i, *blocks[i]);
+    EXPECT_EQ(10000u, alloc.arena()->live_blocks());
+    for (int *p : blocks)
+        alloc.deallocate(p, 1);
+    EXPECT_EQ(0u, alloc.arena()->live_blocks());
+}
+
+TEST(ArenaAllocatorTest, ReusesBlocks)
+{
+    mdl::arena_allocator<double> alloc;
+    double *keep = alloc.allocate(1);
+    double *first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    double *second = alloc.allocate(1);
+    EXPECT_EQ(first, second);
+    alloc.deallocate(second, 1);
+    alloc.deallocate(keep, 1);
+}
+
+TEST(ArenaAllocatorTest, LargeAllocations)
+{
+    mdl::arena_allocator<char> alloc;
+    size_t size = mdl::arena::max_block_size * 4;
+    char *p = alloc.allocate(size);
+    for (size_t i = 0; i < size; ++i)
+        p[i] = char(i);
+    for (size_t i = 0; i < size; ++i)
+        EXPECT_EQ(char(i), p[i]);
+    alloc.deallocate(p, size);
+    EXPECT_EQ(0u, alloc.arena()->capacity());
+}
+
+TEST(ArenaAllocatorTest, BulkReleaseOnClear)
+{
+    mdl::arena_allocator<int> alloc;
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>> list(std::less<int>(), alloc);
+    for (int i : mdl::range<int>(100000))
+        list.insert(list.end(), i);
+    EXPECT_EQ(100000u, alloc.arena()->live_blocks());
+    EXPECT_LT(mdl::arena::default_chunk_size, alloc.arena()->capacity());
+
+    list.clear();
+    EXPECT_EQ(0u, alloc.arena()->live_blocks());
+    EXPECT_EQ(mdl::arena::default_chunk_size, alloc.arena()->capacity());
+
+    list.insert(1);
+    EXPECT_EQ(1, list.front());
+}
+
+TEST(ArenaAllocatorTest, CopiesGetOwnArena)
+{
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>, mdl::btree_backend<>> list;
+    for (int i : mdl::range<int>(1000))
+        list.insert(i % 10);
+    auto copy = list;
+    EXPECT_NE(list.get_allocator(), copy.get_allocator());
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), copy.begin()));
+
+    auto arena = list.get_allocator().arena();
+    auto moved = std::move(list);
+    EXPECT_EQ(arena, moved.get_allocator().arena());
+    EXPECT_EQ(1000u, moved.size());
+    moved.clear();
+    EXPECT_EQ(0u, moved.get_allocator().arena()->live_blocks());
+    EXPECT_EQ(1000u, copy.size());
+}
+
+TEST(ArenaAllocatorTest, Backends)
+{
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>, mdl::indexed_list_backend> indexed;
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>, mdl::flat_backend> flat;
+    for (int i : mdl::range<int>(5000))
+    {
+        indexed.insert((i * 37) % 1000);
+        flat.insert((i * 37) % 1000);
+    }
+    EXPECT_TRUE(std::equal(indexed.begin(), indexed.end(), flat.begin()));
+    indexed.clear();
+    EXPECT_EQ(0u, indexed.get_allocator().arena()->live_blocks());
+}
+
+template<typename Backend>
+static void insert_after_move()
+{
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>, Backend> list;
+    list.insert(1);
+    auto moved(std::move(list));
+    list.clear();
+    list.insert(2);
+    list.insert(1);
+    EXPECT_EQ(2u, list.size());
+    EXPECT_EQ(1, list.front());
+    EXPECT_EQ(list.get_allocator(), moved.get_allocator());
+    EXPECT_EQ(1u, moved.size());
+}
+
+TEST(ArenaAllocatorTest, MovedFromContainerStaysUsable)
+{
+    insert_after_move<mdl::list_backend>();
+    insert_after_move<mdl::flat_backend>();
+    insert_after_move<mdl::btree_backend<>>();
+    insert_after_move<mdl::indexed_list_backend>();
+
+    std::list<int, mdl::arena_allocator<int>> list{1, 2, 3};
+    auto moved(std::move(list));
+    list.clear();
+    list.push_back(4);
+    EXPECT_EQ(4, list.front());
+    EXPECT_EQ(3u, moved.size());
+}
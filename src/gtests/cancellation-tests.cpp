@@ -0,0 +1,57 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <thread>
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/cancellation.hpp>
+
+TEST(CancellationTest, DefaultToken)
+{
+    mdl::cancellation_token token;
+    EXPECT_FALSE(token.can_be_cancelled());
+    EXPECT_FALSE(token.is_cancelled());
+    EXPECT_NO_THROW(token.throw_if_cancelled());
+}
+
+TEST(CancellationTest, Cancel)
+{
+    mdl::cancellation_source source;
+    mdl::cancellation_token token = source.token();
+    mdl::cancellation_token copy = token;
+    EXPECT_TRUE(token.can_be_cancelled());
+    EXPECT_FALSE(token.is_cancelled());
+
+    source.cancel();
+    EXPECT_TRUE(source.is_cancelled());
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_TRUE(copy.is_cancelled());
+    EXPECT_THROW(token.throw_if_cancelled(), mdl::operation_cancelled_exception);
+
+    // Other sources are unaffected
+    mdl::cancellation_source other;
+    EXPECT_FALSE(other.token().is_cancelled());
+}
+
+TEST(CancellationTest, PollFromOtherThread)
+{
+    mdl::cancellation_source source;
+    mdl::cancellation_token token = source.token();
+    std::atomic<int> polls{0};
+    std::thread worker([token, &polls]()
+        {
+            while (!token.is_cancelled())
+            {
+                ++polls;
+                std::this_thread::yield();
+            }
+        });
+    while (polls == 0)
+        std::this_thread::yield();
+    source.cancel();
+    worker.join();
+    EXPECT_GT(polls, 0);
+}
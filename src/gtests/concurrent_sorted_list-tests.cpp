@@ -0,0 +1,151 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/concurrent_sorted_list.hpp>
+#include <mdlutils/multithreading/thread_pool.hpp>
+#include <mdlutils/types/range.hpp>
+
+TEST(ConcurrentSortedListTest, MatchesMultiset)
+{
+    mdl::concurrent_sorted_list<int> list;
+    std::multiset<int> reference;
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<int> distribution(0, 199);
+    for (int i : mdl::range<int>(2000))
+    {
+        int value = distribution(engine);
+        list.insert(value);
+        reference.insert(value);
+        if (i % 3 == 0)
+        {
+            int erased = distribution(engine);
+            ASSERT_EQ(reference.erase(erased), list.erase(erased));
+        }
+    }
+    ASSERT_EQ(reference.size(), list.size());
+    ASSERT_TRUE(std::equal(reference.begin(), reference.end(), list.begin()));
+
+    for (int value = -1; value <= 200; ++value)
+    {
+        ASSERT_EQ(reference.count(value), list.count(value));
+        auto range = list.equal_range(value);
+        ASSERT_EQ(std::distance(list.begin(), range.first),
+                  std::distance(reference.begin(), reference.lower_bound(value)));
+        ASSERT_EQ(std::distance(list.begin(), range.second),
+                  std::distance(reference.begin(), reference.upper_bound(value)));
+        if (reference.count(value))
+            ASSERT_EQ(value, *list.find(value));
+        else
+            ASSERT_EQ(list.end(), list.find(value));
+    }
+}
+
+TEST(ConcurrentSortedListTest, EquivalentElementsKeepOrder)
+{
+    typedef std::pair<int, int> item_t;
+    struct first_less
+    {
+        bool operator()(const item_t &a, const item_t &b) const { return a.first < b.first; }
+    };
+    mdl::concurrent_sorted_list<item_t, first_less> list;
+    for (int i : mdl::range<int>(500))
+        list.insert(item_t(i % 5, i));
+    int previous = -1;
+    for (const item_t &item : list)
+    {
+        if (item.first == 0)
+        {
+            ASSERT_LT(previous, item.second);
+            previous = item.second;
+        }
+    }
+}
+
+TEST(ConcurrentSortedListTest, ConcurrentInsertAndErase)
+{
+    const int threads = 4, per_thread = 3000;
+    mdl::concurrent_sorted_list<int> list;
+    std::vector<std::thread> workers;
+    for (int t : mdl::range<int>(threads))
+        workers.emplace_back([&list, t, threads, per_thread]()
+            {
+                // Interleaved values, so that the threads work on the same parts of the list
+                for (int i : mdl::range<int>(per_thread))
+                    list.insert(i * threads + t);
+                for (int i = 0; i < per_thread; i += 2)
+                    ASSERT_EQ(1u, list.erase(i * threads + t));
+            });
+    for (auto &worker : workers)
+        worker.join();
+
+    ASSERT_EQ(size_t(threads * per_thread / 2), list.size());
+    ASSERT_TRUE(std::is_sorted(list.begin(), list.end()));
+    ASSERT_EQ(size_t(threads * per_thread / 2), size_t(std::distance(list.begin(), list.end())));
+    for (int value : list)
+        ASSERT_EQ(1, (value / threads) % 2);
+}
+
+TEST(ConcurrentSortedListTest, ConcurrentEraseOfSameElements)
+{
+    mdl::concurrent_sorted_list<int> list;
+    for (int i : mdl::range<int>(4000))
+        list.insert(i % 100);
+
+    std::atomic<size_t> removed{0};
+    std::vector<std::thread> workers;
+    for (int t : mdl::range<int>(4))
+        workers.emplace_back([&list, &removed, t]()
+            {
+                for (int i : mdl::range<int>(100))
+                    removed += list.erase((i + t * 25) % 100);
+            });
+    for (auto &worker : workers)
+        worker.join();
+
+    ASSERT_EQ(4000u, removed.load());
+    ASSERT_TRUE(list.empty());
+    ASSERT_EQ(list.end(), list.begin());
+}
+
+TEST(ConcurrentSortedListTest, ThreadPoolWorkers)
+{
+    mdl::thread_pool pool;
+    mdl::concurrent_sorted_list<std::string> index;
+    pool.parallel_for(mdl::range<int>(2000), [&index](int i)
+        {
+            index.insert("record " + std::to_string(i % 500));
+        });
+
+    ASSERT_EQ(2000u, index.size());
+    ASSERT_EQ(4u, index.count("record 42"));
+    ASSERT_TRUE(std::is_sorted(index.begin(), index.end()));
+}
+
+TEST(ConcurrentSortedListTest, IteratorsSurviveErase)
+{
+    mdl::concurrent_sorted_list<int> list;
+    for (int i : mdl::range<int>(10))
+        list.insert(i);
+    auto it = list.find(5);
+    ASSERT_TRUE(list.erase(it));
+    ASSERT_FALSE(list.erase(it));
+    ASSERT_EQ(5, *it);
+    ++it;
+    ASSERT_EQ(6, *it);
+
+    list.clear();
+    ASSERT_TRUE(list.empty());
+    list.collect();
+    list.insert(1);
+    ASSERT_EQ(1, *list.begin());
+}
@@ -0,0 +1,111 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/multithreading/coroutine.hpp>
+#include <mdlutils/multithreading/thread_pool.hpp>
+#include <mdlutils/multithreading/looper.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    int add(int a, int b) { return a + b; }
+
+    mdl::future<std::thread::id> hop(mdl::thread_pool &pool)
+    {
+        co_await pool.schedule();
+        co_return std::this_thread::get_id();
+    }
+
+    mdl::future<int> pipeline(mdl::thread_pool &pool)
+    {
+        int a = co_await pool.async(add, 1, 2);
+        int b = co_await pool.async(add, a, 3);
+        co_return a + b;
+    }
+
+    mdl::future<void> failing(mdl::thread_pool &pool)
+    {
+        co_await pool.async([]() -> int { throw std::runtime_error("failed"); });
+    }
+
+    mdl::future<std::thread::id> sleep_on(mdl::looper &looper, std::chrono::milliseconds duration)
+    {
+        co_await looper.schedule_after(duration);
+        co_return std::this_thread::get_id();
+    }
+
+    // Awaits a task queued on the same pool, which would deadlock a single worker with a blocking get()
+    mdl::future<int> nested(mdl::thread_pool &pool)
+    {
+        co_await pool.schedule();
+        int result = co_await pool.async(add, 2, 2);
+        co_return result;
+    }
+}
+
+TEST(CoroutineTest, ScheduleOnPool)
+{
+    mdl::thread_pool pool(2);
+    EXPECT_NE(std::this_thread::get_id(), hop(pool).get());
+}
+
+TEST(CoroutineTest, AwaitFutures)
+{
+    mdl::thread_pool pool(2);
+    EXPECT_EQ(9, pipeline(pool).get());
+    EXPECT_THROW(failing(pool).get(), std::runtime_error);
+}
+
+TEST(CoroutineTest, ScheduleAfterOnLooper)
+{
+    mdl::looper_thread looper;
+    auto start = std::chrono::steady_clock::now();
+    mdl::future<std::thread::id> woken = sleep_on(looper, std::chrono::milliseconds(20));
+    EXPECT_EQ(looper.get_id(), woken.get());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    looper.stop_and_join_safely();
+}
+
+TEST(CoroutineTest, NoBlockedWorkers)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    std::vector<mdl::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(nested(pool));
+    for (auto &result : results)
+        EXPECT_EQ(4, result.get());
+}
+
+TEST(CoroutineTest, DroppedResumption)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> blocking{false};
+    mdl::future<void> blocker = pool.async([opened, &blocking]()
+        {
+            blocking = true;
+            opened.wait();
+        });
+    while (!blocking)
+        std::this_thread::yield();
+    mdl::future<std::thread::id> suspended = hop(pool);
+    std::thread opener([&gate]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.set_value();
+        });
+    pool.shutdown(mdl::thread_pool::shutdown_mode::cancel_pending);
+    opener.join();
+    blocker.get();
+    // The coroutine is destroyed instead of being resumed, breaking its promise
+    EXPECT_THROW(suspended.get(), std::future_error);
+}
@@ -175,3 +175,28 @@ TEST_F(ExceptionsTest, FloatInvalidArgumentException)
     test_numeric_invalid_argument_exception<double>(1);
     test_numeric_invalid_argument_exception<long double>(1);
 }
+
+TEST_F(ExceptionsTest, ExceptionList)
+{
+    mdl::exception_list errors;
+    EXPECT_TRUE(errors.empty());
+    errors.push_back(std::make_exception_ptr(std::runtime_error("first")));
+    errors.push_back(std::make_exception_ptr(std::logic_error("second")));
+    EXPECT_EQ(2, errors.size());
+    EXPECT_THROW(std::rethrow_exception(errors[0]), std::runtime_error);
+    EXPECT_THROW(std::rethrow_exception(errors[1]), std::logic_error);
+
+    size_t count = 0;
+    for (auto &error : errors)
+        count += error != nullptr;
+    EXPECT_EQ(2, count);
+
+    try
+    {
+        throw errors;
+    }
+    catch (const std::exception &e)
+    {
+        EXPECT_STREQ("mdl::exception_list", e.what());
+    }
+}
@@ -0,0 +1,155 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/future.hpp>
+#include <mdlutils/multithreading/thread_pool.hpp>
+#include <mdlutils/types/range.hpp>
+
+TEST(FutureTest, PromiseValue)
+{
+    mdl::promise<int> p;
+    mdl::future<int> f = p.get_future();
+    EXPECT_TRUE(f.valid());
+    EXPECT_FALSE(f.is_ready());
+    std::thread setter([&p]() { p.set_value(42); });
+    EXPECT_EQ(42, f.get());
+    EXPECT_FALSE(f.valid());
+    setter.join();
+    EXPECT_THROW(p.set_value(1), std::future_error);
+}
+
+TEST(FutureTest, BrokenPromise)
+{
+    mdl::future<void> f;
+    {
+        mdl::promise<void> p;
+        f = p.get_future();
+    }
+    EXPECT_THROW(f.get(), std::future_error);
+}
+
+TEST(FutureTest, ThenWithoutExecutor)
+{
+    mdl::promise<int> p;
+    mdl::future<std::string> f = p.get_future()
+            .then([](int x) { return x * 2; })
+            .then([](int x) { return std::to_string(x); });
+    p.set_value(21);
+    EXPECT_TRUE(f.is_ready());
+    EXPECT_EQ("42", f.get());
+}
+
+TEST(FutureTest, ThenPropagatesExceptions)
+{
+    mdl::promise<int> p;
+    bool called = false;
+    mdl::future<void> f = p.get_future()
+            .then([](int) -> int { throw std::runtime_error("stage"); })
+            .then([&called](int) { called = true; });
+    p.set_value(1);
+    EXPECT_THROW(f.get(), std::runtime_error);
+    EXPECT_FALSE(called);
+}
+
+TEST(FutureTest, AsyncException)
+{
+    mdl::thread_pool pool(2);
+    mdl::future<int> f = pool.async([]() -> int { throw std::runtime_error("async"); });
+    EXPECT_THROW(f.get(), std::runtime_error);
+}
+
+TEST(FutureTest, PipelineOnSingleWorker)
+{
+    // Each stage is scheduled on the pool once the previous one is done, so one worker is enough
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    mdl::future<int> f = pool.async([]() { return 0; });
+    for (int i : mdl::range<int>(100))
+        f = f.then([i](int x) { return x + i; });
+    EXPECT_EQ(99 * 100 / 2, f.get());
+}
+
+TEST(FutureTest, WhenAll)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    std::vector<mdl::future<int>> parts;
+    for (int i : mdl::range<int>(50))
+        parts.push_back(pool.async([i]() { return i * i; }));
+    mdl::future<int> total = mdl::when_all(std::move(parts)).then([](std::vector<int> values)
+        {
+            int sum = 0;
+            for (int v : values)
+                sum += v;
+            return sum;
+        });
+    EXPECT_EQ(49 * 50 * 99 / 6, total.get());
+
+    std::vector<mdl::future<void>> none;
+    mdl::when_all(std::move(none)).get();
+
+    std::vector<mdl::future<void>> failing;
+    failing.push_back(pool.async([]() { }));
+    failing.push_back(pool.async([]() { throw std::runtime_error("part"); }));
+    EXPECT_THROW(mdl::when_all(std::move(failing)).get(), std::runtime_error);
+}
+
+TEST(FutureTest, WhenAny)
+{
+    mdl::promise<int> slow, fast;
+    std::vector<mdl::future<int>> inputs;
+    inputs.push_back(slow.get_future());
+    inputs.push_back(fast.get_future());
+    mdl::future<mdl::when_any_result<int>> any = mdl::when_any(std::move(inputs));
+    EXPECT_FALSE(any.is_ready());
+    fast.set_value(7);
+    mdl::when_any_result<int> result = any.get();
+    EXPECT_EQ(1, result.index);
+    EXPECT_EQ(7, result.futures[1].get());
+    slow.set_value(3);
+    EXPECT_EQ(3, result.futures[0].get());
+}
+
+TEST(FutureTest, ThenAfterPoolDestroyed)
+{
+    mdl::future<int> f;
+    {
+        mdl::thread_pool pool(2);
+        f = pool.async([]() { return 20; });
+        f.wait();
+    }
+    // The continuation can't run on the destroyed pool, so it is run in place
+    mdl::future<int> g = f.then([](int x) { return x + 1; });
+    ASSERT_TRUE(g.is_ready());
+    EXPECT_EQ(21, g.get());
+}
+
+TEST(FutureTest, ThenAfterShutdown)
+{
+    mdl::thread_pool pool(2);
+    mdl::promise<void> gate;
+    mdl::future<void> opened = gate.get_future();
+    mdl::future<int> done = pool.async([]() { return 30; });
+    mdl::future<int> slow = pool.async([&opened]() { opened.wait(); return 1; });
+    mdl::future<int> next = slow.then([](int x) { return x + 1; });
+    std::thread opener([&gate]()
+                           {
+                               std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                               gate.set_value();
+                           });
+    // The continuation of the slow task is scheduled while the pool is draining, so it runs in place
+    pool.shutdown();
+    opener.join();
+    ASSERT_TRUE(next.wait_for(std::chrono::milliseconds(500)));
+    EXPECT_EQ(2, next.get());
+
+    mdl::future<int> after = done.then([](int x) { return x + 1; });
+    ASSERT_TRUE(after.wait_for(std::chrono::milliseconds(500)));
+    EXPECT_EQ(31, after.get());
+}
@@ -0,0 +1,41 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/latch.hpp>
+#include <mdlutils/types/range.hpp>
+
+TEST(LatchTest, CountDown)
+{
+    mdl::latch l(3);
+    EXPECT_FALSE(l.try_wait());
+    l.count_down();
+    l.count_down(2);
+    EXPECT_TRUE(l.try_wait());
+    l.wait();
+}
+
+TEST(LatchTest, ReleasesWaitingThreads)
+{
+    const int n = 8;
+    mdl::latch l(n);
+    std::atomic<int> arrived{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n; ++i)
+        threads.emplace_back([&]()
+                                 {
+                                     ++arrived;
+                                     l.arrive_and_wait();
+                                     EXPECT_EQ(n, arrived.load());
+                                 });
+    l.wait();
+    EXPECT_EQ(n, arrived.load());
+    for (auto &thread : threads)
+        thread.join();
+}
@@ -2,6 +2,12 @@
 // Created by marandil on 11.09.15.
 //
 
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <future>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <mdlutils/multithreading/looper.hpp>
@@ -41,4 +47,217 @@ TEST_F(LooperTest, SimpleNullCall)
 {
     looper.send_message(nullptr);
     looper.stop_and_join_safely();
-}
\ No newline at end of file
+}
+
+TEST_F(LooperTest, WakeUpFromPark)
+{
+    looper.idle_spins = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    looper.send_message(nullptr);
+    looper.stop_and_join_safely();
+    EXPECT_EQ(1, history.size());
+}
+
+struct counted_message : mdl::message
+{
+    counted_message() : mdl::message(mdl::message_type_id<counted_message>()) { }
+};
+
+TEST_F(LooperTest, MessageTypes)
+{
+    EXPECT_EQ(0, mdl::message_type_id<mdl::message>());
+    EXPECT_NE(mdl::message_type_id<mdl::post_call>(), mdl::message_type_id<mdl::break_message>());
+    EXPECT_EQ(mdl::message_type_id<counted_message>(), counted_message().type);
+    EXPECT_TRUE(mdl::is_message<counted_message>(std::make_shared<counted_message>()));
+    EXPECT_FALSE(mdl::is_message<counted_message>(std::make_shared<mdl::message>()));
+    EXPECT_FALSE(mdl::is_message<counted_message>(nullptr));
+}
+
+TEST_F(LooperTest, DispatchByType)
+{
+    struct counting_handler : mdl::handler
+    {
+        std::atomic<int> handled{0};
+
+        virtual bool handle_message(mdl::message_ptr /*msg*/)
+        {
+            ++handled;
+            return true;
+        }
+
+        virtual bool accepts(mdl::message_type type) const
+        {
+            return type == mdl::message_type_id<counted_message>();
+        }
+    } counter;
+
+    mdl::looper_thread typed_looper(counter);
+    typed_looper.send_message(std::make_shared<counted_message>());
+    typed_looper.send_message(std::make_shared<mdl::message>());
+    typed_looper.send_message(std::make_shared<counted_message>());
+    typed_looper.stop_and_join_safely();
+    EXPECT_EQ(2, counter.handled.load());
+}
+
+// CPU time consumed so far by the looper thread, sampled on the looper itself.
+double looper_cpu_ms(mdl::looper_thread &looper)
+{
+    std::promise<double> cpu_ms;
+    looper.post<void>([&cpu_ms]()
+                          {
+                              timespec now;
+                              clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+                              cpu_ms.set_value(now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0);
+                          });
+    return cpu_ms.get_future().get();
+}
+
+TEST_F(LooperTest, DelayedMessages)
+{
+    looper.idle_spins = 0;
+    double start_ms = looper_cpu_ms(looper);
+    looper.post_delayed<void>([]() { history.push_back(3); }, std::chrono::milliseconds(60));
+    looper.post_delayed<void>([]() { history.push_back(1); }, std::chrono::milliseconds(20));
+    looper.post_at_time<void>([]() { history.push_back(2); }, mdl::helper::delay_by(std::chrono::milliseconds(40)));
+    looper.post_delayed<void>([]() { history.push_back(4); }, std::chrono::milliseconds(60));
+    looper.post<void>([]() { history.push_back(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double cpu_ms = looper_cpu_ms(looper) - start_ms;
+    looper.stop_and_join_safely();
+    ASSERT_EQ(5, history.size());
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(i, history[i]);
+    // Pending delayed messages should not keep the looper busy
+    EXPECT_LT(cpu_ms, 50.0);
+}
+
+TEST_F(LooperTest, CancelDelayed)
+{
+    mdl::cancellation_source source;
+    looper.post_delayed<void>([]() { history.push_back(1); }, std::chrono::milliseconds(20), source.token());
+    looper.post_at_time<void>([]() { history.push_back(2); }, mdl::helper::delay_by(std::chrono::milliseconds(20)),
+                              source.token());
+    looper.post_delayed<void>([]() { history.push_back(0); }, std::chrono::milliseconds(20),
+                              mdl::cancellation_source().token());
+    source.cancel();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    looper.stop_and_join_safely();
+    ASSERT_EQ(1, history.size());
+    EXPECT_EQ(0, history[0]);
+}
+
+TEST_F(LooperTest, Priorities)
+{
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> blocking_started{false};
+    looper.post<void>([opened, &blocking_started]()
+        {
+            blocking_started = true;
+            opened.wait();
+        });
+    while (!blocking_started)
+        std::this_thread::yield();
+    for (int i = 0; i < 10; ++i)
+        looper.post<void>([]() { history.push_back(2); }, mdl::priority::bulk);
+    for (int i = 0; i < 10; ++i)
+        looper.post<void>([]() { history.push_back(1); });
+    for (int i = 0; i < 10; ++i)
+        looper.post<void>([]() { history.push_back(0); }, mdl::priority::critical);
+    gate.set_value();
+    looper.stop_and_join_safely();
+
+    // Weighted rounds of 8 critical, 4 normal and 1 bulk message (the blocking one used up a normal credit)
+    std::deque<int> expected;
+    expected.insert(expected.end(), 8, 0);
+    expected.insert(expected.end(), 3, 1);
+    expected.insert(expected.end(), 1, 2);
+    expected.insert(expected.end(), 2, 0);
+    expected.insert(expected.end(), 4, 1);
+    expected.insert(expected.end(), 1, 2);
+    expected.insert(expected.end(), 3, 1);
+    expected.insert(expected.end(), 8, 2);
+    // The break message has been deferred until all the messages were handled
+    EXPECT_EQ(expected, history);
+}
+
+TEST_F(LooperTest, MessagesAfterSafeStop)
+{
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> blocking_started{false};
+    looper.post<void>([opened, &blocking_started]()
+        {
+            blocking_started = true;
+            opened.wait();
+        });
+    while (!blocking_started)
+        std::this_thread::yield();
+    looper.post<void>([]() { history.push_back(0); }, mdl::priority::bulk);
+    looper.post<void>([]() { history.push_back(1); });
+    looper.stop_safely();
+    looper.post<void>([]() { history.push_back(2); });
+    gate.set_value();
+    looper.wait_until_finished();
+
+    // The messages sent before the break are handled, even the less urgent ones, but not the ones sent after it
+    std::sort(history.begin(), history.end());
+    EXPECT_EQ(std::deque<int>({0, 1}), history);
+}
+
+TEST_F(LooperTest, SendMessages)
+{
+    struct counting_handler : mdl::handler
+    {
+        std::atomic<int> handled{0};
+
+        virtual bool handle_message(mdl::message_ptr /*msg*/)
+        {
+            ++handled;
+            return true;
+        }
+
+        virtual bool accepts(mdl::message_type type) const
+        {
+            return type == mdl::message_type_id<counted_message>();
+        }
+    } counter;
+
+    mdl::looper_thread typed_looper(counter);
+    std::vector<mdl::message_ptr> batch;
+    for (int i = 0; i < 100; ++i)
+        batch.push_back(std::make_shared<counted_message>());
+    typed_looper.send_messages(batch.begin(), batch.end());
+    typed_looper.send_messages(batch.begin(), batch.begin() + 10, mdl::priority::bulk);
+    typed_looper.stop_and_join_safely();
+    EXPECT_EQ(110, counter.handled.load());
+}
+
+TEST_F(LooperTest, Metrics)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int i = 0; i < 10; ++i)
+        looper.post<void>([]() { std::this_thread::sleep_for(std::chrono::microseconds(100)); });
+    looper.stop_and_join_safely();
+
+    mdl::looper_metrics metrics = looper.metrics();
+    EXPECT_EQ(10, metrics.tasks_executed);
+    // The break message breaks out of the loop, instead of being handled
+    EXPECT_EQ(10, metrics.messages_handled);
+    EXPECT_GE(metrics.queue_high_water, 1);
+    EXPECT_GE(metrics.handler_time, std::chrono::milliseconds(1));
+    EXPECT_GT(metrics.idle_time, mdl::duration_t::zero());
+    EXPECT_GE(metrics.wakeups, 1);
+    EXPECT_EQ(0, metrics.steals);
+    uint64_t histogram_total = 0;
+    for (size_t i = 0; i < mdl::looper_metrics::histogram_buckets; ++i)
+    {
+        histogram_total += metrics.task_times[i];
+        // 100us falls into [2^16, 2^17) ns, nothing much shorter is expected
+        if (i < 16)
+        {
+            EXPECT_EQ(0, metrics.task_times[i]);
+        }
+    }
+    EXPECT_EQ(10, histogram_total);
+}
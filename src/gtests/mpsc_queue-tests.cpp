@@ -0,0 +1,121 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/mpsc_queue.hpp>
+#include <mdlutils/types/range.hpp>
+
+class MPSCQueueTest : public ::testing::Test
+{
+protected:
+    mdl::mpsc_queue<int> queue;
+};
+
+TEST_F(MPSCQueueTest, EmptyQueue)
+{
+    int value;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.ready());
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST_F(MPSCQueueTest, FIFOOrder)
+{
+    for (int i : mdl::range<int>(10))
+        queue.push(i);
+    EXPECT_EQ(10, queue.size());
+    int value;
+    for (int i : mdl::range<int>(10))
+    {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MPSCQueueTest, ReleasesElements)
+{
+    std::shared_ptr<int> element = std::make_shared<int>(5);
+    {
+        mdl::mpsc_queue<std::shared_ptr<int>> pointers;
+        pointers.push(element);
+        pointers.push(element);
+        std::shared_ptr<int> popped;
+        ASSERT_TRUE(pointers.pop(popped));
+        popped = nullptr;
+        EXPECT_EQ(2, element.use_count());
+    }
+    EXPECT_EQ(1, element.use_count());
+}
+
+TEST_F(MPSCQueueTest, MultipleProducers)
+{
+    const int producers = 4, n = 25000;
+    std::vector<std::thread> threads;
+    for (int p : mdl::range<int>(producers))
+        threads.emplace_back([this, p, n]()
+                                 {
+                                     for (int i : mdl::range<int>(n))
+                                         queue.push(p * n + i);
+                                 });
+
+    // Elements of each producer have to be received in order
+    std::vector<int> last(producers, -1);
+    int received = 0, value;
+    while (received < producers * n)
+    {
+        if (!queue.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_LT(last[value / n], value % n);
+        last[value / n] = value % n;
+        ++received;
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MPSCQueueTest, PushBatches)
+{
+    const int producers = 4, batches = 1000, batch_size = 10;
+    std::vector<std::thread> threads;
+    for (int p : mdl::range<int>(producers))
+        threads.emplace_back([this, p, batches, batch_size]()
+                                 {
+                                     mdl::range<int> batch(p * batches * batch_size, (p + 1) * batches * batch_size);
+                                     for (int b : mdl::range<int>(batches))
+                                         EXPECT_EQ(batch_size, queue.push(batch.begin() + b * batch_size,
+                                                                          batch.begin() + (b + 1) * batch_size));
+                                 });
+    std::vector<int> none;
+    EXPECT_EQ(0, queue.push(none.begin(), none.end()));
+
+    // Batches are never interleaved with other pushes
+    int received = 0, value;
+    while (received < producers * batches * batch_size)
+    {
+        if (!queue.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (received % batch_size == 0)
+            EXPECT_EQ(0, value % batch_size);
+        else
+            EXPECT_EQ(received % batch_size, value % batch_size);
+        ++received;
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,93 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <thread>
+#include <vector>
+#include <list>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/memory/pool_allocator.hpp>
+#include <mdlutils/types/range.hpp>
+
+TEST(PoolAllocatorTest, AlignedAndDistinct)
+{
+    mdl::pool_allocator<int> alloc;
+    std::vector<int *> blocks;
+    for (int i : mdl::range<int>(200))
+    {
+        int *p = alloc.allocate(1);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % mdl::helper::block_pool::block_alignment);
+        *p = i;
+        blocks.push_back(p);
+    }
+    for (int i : mdl::range<int>(200))
+        EXPECT_EQ(i, *blocks[i]);
+    for (int *p : blocks)
+        alloc.deallocate(p, 1);
+}
+
+TEST(PoolAllocatorTest, ReusesBlocks)
+{
+    mdl::pool_allocator<double> alloc;
+    double *first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    double *second = alloc.allocate(1);
+    EXPECT_EQ(first, second);
+    alloc.deallocate(second, 1);
+}
+
+TEST(PoolAllocatorTest, LargeAllocations)
+{
+    mdl::pool_allocator<char> alloc;
+    size_t size = mdl::helper::block_pool::max_block_size * 4;
+    char *p = alloc.allocate(size);
+    for (size_t i = 0; i < size; ++i)
+        p[i] = char(i);
+    for (size_t i = 0; i < size; ++i)
+        EXPECT_EQ(char(i), p[i]);
+    alloc.deallocate(p, size);
+}
+
+TEST(PoolAllocatorTest, Container)
+{
+    std::list<int, mdl::pool_allocator<int>> values;
+    for (int i : mdl::range<int>(1000))
+        values.push_back(i);
+    int expected = 0;
+    for (int i : values)
+        EXPECT_EQ(expected++, i);
+    EXPECT_TRUE(mdl::pool_allocator<int>() == mdl::pool_allocator<char>());
+}
+
+TEST(PoolAllocatorTest, RemoteFree)
+{
+    const int n = 10000;
+    mdl::pool_allocator<int> alloc;
+    std::vector<int *> blocks;
+    std::thread producer([&]()
+                             {
+                                 for (int i : mdl::range<int>(n))
+                                 {
+                                     blocks.push_back(alloc.allocate(1));
+                                     *blocks.back() = i;
+                                 }
+                             });
+    producer.join();
+    // Release on a different thread (the owner has already exited), then allocate again
+    for (int i : mdl::range<int>(n))
+    {
+        EXPECT_EQ(i, *blocks[i]);
+        alloc.deallocate(blocks[i], 1);
+    }
+    std::thread consumer([&]()
+                             {
+                                 for (int *&p : blocks)
+                                     p = alloc.allocate(1);
+                                 for (int *p : blocks)
+                                     alloc.deallocate(p, 1);
+                             });
+    consumer.join();
+}
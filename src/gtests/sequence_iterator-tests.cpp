@@ -98,3 +98,17 @@ TEST_F(SequenceIteratorTest, IntBasicRangeDec)
     test_basic_range_dec(5, 1, -1);
     test_basic_range_dec(1000, 0, -2);
 }
+
+TEST_F(SequenceIteratorTest, IntRandomAccess)
+{
+    mdl::sequence_iterator<int> it(10, 3);
+    EXPECT_EQ(22, *(it + 4));
+    EXPECT_EQ(4, *(it - 2));
+    EXPECT_EQ(22, *(4 + it));
+    EXPECT_EQ(16, it[2]);
+    it += 5;
+    EXPECT_EQ(25, *it);
+    it -= 2;
+    EXPECT_EQ(19, *it);
+    EXPECT_EQ(3, it - mdl::sequence_iterator<int>(10, 3));
+}
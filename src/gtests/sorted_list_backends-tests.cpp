@@ -0,0 +1,260 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/types/sorted_list.hpp>
+
+template<typename Backend>
+class SortedListBackendTest : public ::testing::Test
+{
+protected:
+    template<typename T, typename Compare = std::less<T>>
+    using list_t = mdl::sorted_list<T, Compare, std::allocator<T>, Backend>;
+
+    std::mt19937 engine{42};
+
+    // Values with many duplicates, so that the equivalence classes span several nodes.
+    std::vector<int> random_values(size_t n, int range)
+    {
+        std::uniform_int_distribution<int> distribution(0, range - 1);
+        std::vector<int> values(n);
+        for (auto &value : values)
+            value = distribution(engine);
+        return values;
+    }
+};
+
+// The tiny B+-tree nodes (4 elements or children) exercise the splits and the merges on small inputs.
+typedef ::testing::Types<mdl::list_backend, mdl::indexed_list_backend, mdl::flat_backend, mdl::btree_backend<>,
+        mdl::btree_backend<16>> SortedListBackends;
+TYPED_TEST_CASE(SortedListBackendTest, SortedListBackends);
+
+TYPED_TEST(SortedListBackendTest, InsertKeepsOrder)
+{
+    typename TestFixture::template list_t<int> list;
+    std::multiset<int> reference;
+    for (int value : this->random_values(1000, 100))
+    {
+        list.insert(value);
+        reference.insert(value);
+    }
+    ASSERT_TRUE(list == reference);
+    ASSERT_EQ(list.front(), *reference.begin());
+    ASSERT_EQ(list.back(), *reference.rbegin());
+    ASSERT_TRUE(std::equal(list.rbegin(), list.rend(), reference.rbegin()));
+}
+
+TYPED_TEST(SortedListBackendTest, HintInsertion)
+{
+    typename TestFixture::template list_t<int, std::greater<int>> list;
+    std::multiset<int, std::greater<int>> reference;
+    auto it = list.begin();
+    for (int value : this->random_values(1000, 50))
+    {
+        it = list.insert(it, value); // the hint is mostly wrong, which has to be detected
+        reference.insert(value);
+    }
+    for (int value = 0; value < 1000; ++value) // the hint is always right
+    {
+        list.insert(list.end(), -value);
+        reference.insert(-value);
+    }
+    ASSERT_TRUE(list == reference);
+}
+
+TYPED_TEST(SortedListBackendTest, Lookup)
+{
+    typename TestFixture::template list_t<int> list;
+    std::multiset<int> reference;
+    for (int value : this->random_values(500, 100))
+    {
+        list.insert(value * 2); // odd values are never present
+        reference.insert(value * 2);
+    }
+    for (int value = -1; value <= 201; ++value)
+    {
+        ASSERT_EQ(list.count(value), reference.count(value));
+        ASSERT_EQ(std::distance(list.begin(), list.lower_bound(value)),
+                  std::distance(reference.begin(), reference.lower_bound(value)));
+        ASSERT_EQ(std::distance(list.begin(), list.upper_bound(value)),
+                  std::distance(reference.begin(), reference.upper_bound(value)));
+        if (reference.count(value))
+            ASSERT_EQ(*list.find(value), value);
+        else
+            ASSERT_EQ(list.find(value), list.end());
+    }
+}
+
+TYPED_TEST(SortedListBackendTest, Erase)
+{
+    typename TestFixture::template list_t<int> list;
+    std::multiset<int> reference;
+    for (int value : this->random_values(2000, 200))
+    {
+        list.insert(value);
+        reference.insert(value);
+    }
+    for (int value : this->random_values(100, 200))
+    {
+        ASSERT_EQ(list.erase(value), reference.erase(value));
+        ASSERT_TRUE(list == reference);
+    }
+
+    // Erase every other element with the iterators
+    for (auto it = list.begin(); it != list.end();)
+    {
+        it = list.erase(it);
+        if (it != list.end())
+            ++it;
+    }
+    auto ref = reference.begin();
+    while (ref != reference.end())
+    {
+        ref = reference.erase(ref);
+        if (ref != reference.end())
+            ++ref;
+    }
+    ASSERT_TRUE(list == reference);
+
+    list.erase(list.lower_bound(50), list.upper_bound(150));
+    reference.erase(reference.lower_bound(50), reference.upper_bound(150));
+    ASSERT_TRUE(list == reference);
+
+    while (!list.empty())
+    {
+        list.pop_front();
+        if (!list.empty())
+            list.pop_back();
+    }
+    ASSERT_EQ(list.size(), 0);
+    ASSERT_EQ(list.begin(), list.end());
+}
+
+TYPED_TEST(SortedListBackendTest, CopyAndMove)
+{
+    typename TestFixture::template list_t<std::string> list;
+    std::multiset<std::string> reference;
+    for (int value : this->random_values(300, 30))
+    {
+        list.insert("Alice " + std::to_string(value));
+        reference.insert("Alice " + std::to_string(value));
+    }
+
+    typename TestFixture::template list_t<std::string> copy(list);
+    ASSERT_TRUE(copy == reference);
+    copy.erase("Alice 7");
+    ASSERT_TRUE(list == reference);
+
+    typename TestFixture::template list_t<std::string> moved(std::move(list));
+    ASSERT_TRUE(moved == reference);
+
+    auto converted = static_cast<std::list<std::string>>(moved);
+    ASSERT_TRUE(std::equal(converted.begin(), converted.end(), reference.begin()));
+}
+
+TYPED_TEST(SortedListBackendTest, BulkInsertion)
+{
+    std::vector<int> values = this->random_values(3000, 500);
+    std::multiset<int> reference(values.begin(), values.end());
+    typename TestFixture::template list_t<int> list(values.begin(), values.end());
+    ASSERT_TRUE(list == reference);
+
+    // Small and large unsorted batches, merged into the existing elements
+    for (size_t n : {10, 100, 5000})
+    {
+        std::vector<int> batch = this->random_values(n, 500);
+        auto it = list.insert(batch.begin(), batch.end());
+        reference.insert(batch.begin(), batch.end());
+        ASSERT_TRUE(list == reference);
+        ASSERT_EQ(*it, *std::max_element(batch.begin(), batch.end()));
+        ASSERT_EQ(std::next(it) == list.end() || *std::next(it) > *it, true);
+    }
+
+    // Sorted batch, appended
+    std::vector<int> sorted(1000);
+    for (size_t i = 0; i < sorted.size(); ++i)
+        sorted[i] = 500 + i / 3;
+    list.insert(sorted.begin(), sorted.end());
+    reference.insert(sorted.begin(), sorted.end());
+    ASSERT_TRUE(list == reference);
+
+    std::vector<int> empty;
+    ASSERT_EQ(list.insert(empty.begin(), empty.end()), list.end());
+}
+
+namespace
+{
+    struct first_less
+    {
+        bool operator()(const std::pair<int, int> &a, const std::pair<int, int> &b) const { return a.first < b.first; }
+    };
+}
+
+TYPED_TEST(SortedListBackendTest, BulkInsertionIsStable)
+{
+    typedef std::pair<int, int> item_t;
+    std::vector<item_t> items;
+    for (int i = 0; i < 1000; ++i)
+        items.push_back(item_t(i % 7, i)); // second member records the insertion order
+    typename TestFixture::template list_t<item_t, first_less> list(items.begin(), items.begin() + 500);
+    list.insert(items.begin() + 500, items.end());
+
+    ASSERT_EQ(list.size(), items.size());
+    for (auto it = list.begin(), next = std::next(it); next != list.end(); ++it, ++next)
+    {
+        ASSERT_LE(it->first, next->first);
+        if (it->first == next->first)
+        {
+            ASSERT_LT(it->second, next->second);
+        }
+    }
+}
+
+TYPED_TEST(SortedListBackendTest, HintedInsertionIsStable)
+{
+    typedef std::pair<int, int> item_t;
+    const std::vector<item_t> items = {item_t(1, 0), item_t(2, 1), item_t(2, 2), item_t(3, 3)};
+    std::vector<item_t> expected = items;
+    expected.insert(expected.begin() + 3, item_t(2, 4));
+    for (size_t hint = 0; hint <= items.size(); ++hint)
+    {
+        typename TestFixture::template list_t<item_t, first_less> list;
+        for (const item_t &item : items)
+            list.insert(item);
+        // Whatever the hint, the new element goes after the equivalent ones
+        list.insert(std::next(list.begin(), hint), item_t(2, 4));
+        ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin())) << "hint " << hint;
+    }
+}
+
+TEST(IndexedSortedListTest, IteratorStability)
+{
+    mdl::sorted_list<int, std::less<int>, std::allocator<int>, mdl::indexed_list_backend> list;
+    std::vector<decltype(list.begin())> iterators;
+    for (int value = 0; value < 1000; value += 10)
+        iterators.push_back(list.insert(value));
+
+    // Inserting and erasing other elements (with the index rebuilt by the bulk merges) keeps the iterators valid
+    std::vector<int> batch;
+    for (int value = 0; value < 5000; ++value)
+        batch.push_back((value * 7919) % 1000);
+    list.insert(batch.begin(), batch.begin() + 10);
+    list.insert(batch.begin() + 10, batch.end());
+    for (int value = 1; value < 1000; value += 10)
+        list.erase(value);
+
+    for (size_t i = 0; i < iterators.size(); ++i)
+        ASSERT_EQ(*iterators[i], 10 * static_cast<int>(i));
+    for (size_t i = 0; i < iterators.size(); ++i)
+        list.erase(iterators[i]);
+    ASSERT_EQ(list.count(0), 5);
+    ASSERT_EQ(list.size(), 100 + 5000 - 500 - 100);
+}
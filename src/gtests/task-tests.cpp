@@ -0,0 +1,82 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <memory>
+#include <future>
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/task.hpp>
+
+TEST(TaskTest, EmptyTask)
+{
+    mdl::task t;
+    EXPECT_FALSE(t);
+    mdl::task n = nullptr;
+    EXPECT_FALSE(n);
+}
+
+TEST(TaskTest, SmallCallable)
+{
+    int counter = 0;
+    mdl::task t([&counter]() { ++counter; });
+    ASSERT_TRUE(t);
+    t();
+    t();
+    EXPECT_EQ(2, counter);
+}
+
+TEST(TaskTest, LargeCallable)
+{
+    std::array<int, 64> values;
+    values.fill(1);
+    int sum = 0;
+    mdl::task t([values, &sum]()
+                    {
+                        for (int v : values)
+                            sum += v;
+                    });
+    mdl::task moved = std::move(t);
+    EXPECT_FALSE(t);
+    moved();
+    EXPECT_EQ(64, sum);
+}
+
+struct move_only_call
+{
+    std::promise<int> promise;
+    std::unique_ptr<int> value;
+
+    void operator()() { promise.set_value(*value); }
+};
+
+TEST(TaskTest, MoveOnlyCallable)
+{
+    move_only_call call{std::promise<int>(), std::unique_ptr<int>(new int(42))};
+    std::future<int> future = call.promise.get_future();
+    mdl::task t(std::move(call));
+    mdl::task other;
+    other = std::move(t);
+    other();
+    EXPECT_EQ(42, future.get());
+}
+
+TEST(TaskTest, DestroysCallable)
+{
+    std::shared_ptr<int> small = std::make_shared<int>(0);
+    std::shared_ptr<int> large = std::make_shared<int>(0);
+    {
+        std::array<char, 128> padding;
+        mdl::task a([small]() { });
+        mdl::task b([large, padding]() { });
+        EXPECT_EQ(2, small.use_count());
+        EXPECT_EQ(2, large.use_count());
+        mdl::task c = std::move(a);
+        b = nullptr;
+        EXPECT_EQ(2, small.use_count());
+        EXPECT_EQ(1, large.use_count());
+    }
+    EXPECT_EQ(1, small.use_count());
+}
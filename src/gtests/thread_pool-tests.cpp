@@ -4,6 +4,13 @@
 
 #include <mdlutils/multithreading/thread_pool.hpp>
 
+#include <ctime>
+#include <string>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <thread>
+
 #include <gtest/gtest.h>
 #include <mdlutils/types/range.hpp>
 
@@ -33,7 +40,7 @@ int addc(int a)
 void simple_add_test(mdl::thread_pool &pool)
 {
     int a = 10, b = 15;
-    std::future<int> c = pool.async(add, a, b);
+    mdl::future<int> c = pool.async(add, a, b);
     EXPECT_EQ(a + b, c.get());
 }
 
@@ -41,7 +48,7 @@ template<size_t n>
 void multiple_add_test(mdl::thread_pool &pool)
 {
     std::array<int, n> a, b;
-    std::array<std::future<int>, n> c;
+    std::array<mdl::future<int>, n> c;
     for (size_t i : mdl::range<size_t>(n))
     {
         a[i] = i;
@@ -89,6 +96,96 @@ TEST_F(ThreadPoolTest, MultipleAddP2C)
     multiple_add_test<1000>(pool);
 }
 
+TEST_F(ThreadPoolTest, SimpleAddWorkStealing)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    simple_add_test(pool);
+}
+
+TEST_F(ThreadPoolTest, MultipleAddWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    multiple_add_test<1000>(pool);
+}
+
+// Several threads submitting tasks (one by one, or in batches) at once, from outside of the pool
+void concurrent_producers_test(mdl::thread_pool &pool, bool batches = false)
+{
+    const int producers = 4, tasks = 500, batch = 50;
+    std::vector<std::vector<mdl::future<int>>> results(producers);
+    std::vector<std::thread> threads;
+    for (int t : mdl::range<int>(producers))
+        threads.emplace_back([&pool, &results, t, tasks, batch, batches]()
+                                 {
+                                     for (int i = 0; i < tasks; i += batches ? batch : 1)
+                                     {
+                                         if (!batches)
+                                         {
+                                             results[t].push_back(pool.async(add, t, i));
+                                             continue;
+                                         }
+                                         auto add_t = [t](int value) { return add(t, value); };
+                                         for (auto &f : pool.async_bulk(mdl::range<int>(i, i + batch), add_t))
+                                             results[t].push_back(std::move(f));
+                                     }
+                                 });
+    for (auto &thread : threads)
+        thread.join();
+    for (int t : mdl::range<int>(producers))
+        for (int i : mdl::range<int>(tasks))
+            EXPECT_EQ(t + i, results[t][i].get());
+}
+
+TEST_F(ThreadPoolTest, ConcurrentProducersRoundRobin)
+{
+    mdl::thread_pool pool(3, mdl::thread_pool::strategy::round_robin);
+    concurrent_producers_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ConcurrentProducersWorkStealing)
+{
+    mdl::thread_pool pool(3, mdl::thread_pool::strategy::work_stealing);
+    concurrent_producers_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ConcurrentBatchesRoundRobin)
+{
+    mdl::thread_pool pool(3, mdl::thread_pool::strategy::round_robin);
+    concurrent_producers_test(pool, true);
+}
+
+TEST_F(ThreadPoolTest, ConcurrentBatchesP2C)
+{
+    mdl::thread_pool pool(3, mdl::thread_pool::strategy::power2choices);
+    concurrent_producers_test(pool, true);
+    concurrent_producers_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ConcurrentBatchesWorkStealing)
+{
+    mdl::thread_pool pool(3, mdl::thread_pool::strategy::work_stealing);
+    concurrent_producers_test(pool, true);
+}
+
+bool spawn_tree(mdl::thread_pool &pool, std::atomic<int> &counter, int depth)
+{
+    ++counter;
+    if (depth == 0) return true;
+    pool.async(spawn_tree, std::ref(pool), std::ref(counter), depth - 1);
+    pool.async(spawn_tree, std::ref(pool), std::ref(counter), depth - 1);
+    return true;
+}
+
+TEST_F(ThreadPoolTest, NestedTasksWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    std::atomic<int> counter{0};
+    pool.async(spawn_tree, std::ref(pool), std::ref(counter), 10);
+    while (counter.load() != (1 << 11) - 1)
+        std::this_thread::yield();
+    EXPECT_EQ((1 << 11) - 1, counter.load());
+}
+
 template<size_t n, int c>
 void map_addc_test(mdl::thread_pool &pool)
 {
@@ -115,3 +212,699 @@ TEST_F(ThreadPoolTest, MapP2C)
     mdl::thread_pool pool(4, mdl::thread_pool::strategy::power2choices);
     map_addc_test<1000, 3>(pool);
 }
+
+TEST_F(ThreadPoolTest, MapWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    map_addc_test<1000, 3>(pool);
+}
+
+template<int c>
+void chunked_map_addc_test(mdl::thread_pool &pool, size_t n, size_t grain_size)
+{
+    std::vector<int> a(n), b(n, -1);
+    for (size_t i : mdl::range<size_t>(n))
+        a[i] = int(i);
+    pool.map(a.begin(), a.end(), b.begin(), addc<c>, grain_size);
+    for (size_t i : mdl::range<size_t>(n))
+        EXPECT_EQ(a[i] + c, b[i]);
+}
+
+TEST_F(ThreadPoolTest, ChunkedMapRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    chunked_map_addc_test<3>(pool, 100000, 0);
+    chunked_map_addc_test<3>(pool, 1001, 10);
+}
+
+TEST_F(ThreadPoolTest, ChunkedMapDynamic)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    chunked_map_addc_test<3>(pool, 100000, 0);
+    chunked_map_addc_test<3>(pool, 1001, 10);
+}
+
+TEST_F(ThreadPoolTest, ChunkedMapWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    chunked_map_addc_test<3>(pool, 100000, 0);
+    chunked_map_addc_test<3>(pool, 1001, 10);
+    chunked_map_addc_test<3>(pool, 5, 0);
+    chunked_map_addc_test<3>(pool, 0, 0);
+}
+
+TEST_F(ThreadPoolTest, ChunkedMapException)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    std::vector<int> a(1000, 1), b(1000);
+    a[500] = 0;
+    EXPECT_THROW(pool.map(a.begin(), a.end(), b.begin(), [](int x)
+        {
+            if (x == 0) throw std::runtime_error("zero");
+            return x;
+        }, 16), std::runtime_error);
+    // The pool remains usable
+    simple_add_test(pool);
+}
+
+TEST_F(ThreadPoolTest, MapExceptionList)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    std::vector<int> a(100, 1), b(100);
+    a[10] = a[20] = a[30] = 0;
+    mdl::future<void> done = pool.map(a.begin(), a.end(), b.begin(), [](int x)
+        {
+            if (x == 0) throw std::runtime_error("zero");
+            return x;
+        });
+    try
+    {
+        done.get();
+        FAIL() << "exception_list not thrown";
+    }
+    catch (const mdl::exception_list &errors)
+    {
+        EXPECT_EQ(3, errors.size());
+        for (auto &error : errors)
+            EXPECT_THROW(std::rethrow_exception(error), std::runtime_error);
+    }
+    EXPECT_EQ(1, b[99]);
+}
+
+void collect_exceptions_test(mdl::thread_pool &pool)
+{
+    // More failures than the error rings of the workers can hold
+    const size_t n = 500;
+    mdl::latch started(n);
+    for (size_t i = 0; i < n; ++i)
+        pool.execute([&started]()
+            {
+                started.count_down();
+                throw std::runtime_error("failure");
+            });
+    started.wait();
+
+    size_t collected = 0;
+    for (int attempt = 0; attempt < 1000 && collected < n; ++attempt)
+    {
+        mdl::exception_list errors = pool.collect_exceptions();
+        for (auto &error : errors)
+            EXPECT_THROW(std::rethrow_exception(error), std::runtime_error);
+        collected += errors.size();
+        if (collected < n)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(n, collected);
+    EXPECT_TRUE(pool.collect_exceptions().empty());
+}
+
+TEST_F(ThreadPoolTest, CollectExceptionsRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    collect_exceptions_test(pool);
+}
+
+TEST_F(ThreadPoolTest, CollectExceptionsWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    collect_exceptions_test(pool);
+}
+
+void reduce_test(mdl::thread_pool &pool)
+{
+    std::vector<long long> values(100000);
+    for (size_t i : mdl::range<size_t>(values.size()))
+        values[i] = (long long) i;
+    long long expected = (long long) values.size() * (values.size() - 1) / 2;
+    EXPECT_EQ(expected + 5, pool.reduce(values.begin(), values.end(), 5LL));
+    EXPECT_EQ(expected, pool.reduce(values.begin(), values.end(), 0LL, std::plus<long long>(), 7));
+    EXPECT_EQ(3, pool.reduce(values.begin(), values.begin(), 3LL));
+
+    mdl::range<long long> numbers(1, 1001);
+    EXPECT_EQ(1000 * 1001 * 2001 / 6,
+              pool.transform_reduce(numbers.begin(), numbers.end(), 0LL, std::plus<long long>(),
+                                    [](long long x) { return x * x; }));
+}
+
+TEST_F(ThreadPoolTest, ReduceRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    reduce_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ReduceDynamic)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    reduce_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ReduceWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    reduce_test(pool);
+}
+
+TEST_F(ThreadPoolTest, ReduceKeepsOrder)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    std::vector<char> letters(1000);
+    for (size_t i : mdl::range<size_t>(letters.size()))
+        letters[i] = char('a' + i % 26);
+    std::string expected(letters.begin(), letters.end());
+    // Concatenation is associative, but not commutative
+    EXPECT_EQ(expected, pool.transform_reduce(letters.begin(), letters.end(), std::string(), std::plus<std::string>(),
+                                              [](char c) { return std::string(1, c); }, 10));
+}
+
+TEST_F(ThreadPoolTest, ForEach)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    std::vector<int> values(10000, 1);
+    pool.for_each(values.begin(), values.end(), [](int &x) { x *= 3; });
+    for (int x : values)
+        EXPECT_EQ(3, x);
+
+    std::vector<std::atomic<int>> hits(1000);
+    for (auto &h : hits) h = 0;
+    pool.parallel_for(mdl::range<int>(0, 1000, 2), [&hits](int i) { ++hits[i]; }, 16);
+    for (size_t i : mdl::range<size_t>(hits.size()))
+        EXPECT_EQ(i % 2 ? 0 : 1, hits[i].load());
+}
+
+void bounded_queue_test(mdl::thread_pool &pool)
+{
+    pool.max_queued_tasks = 2;
+    EXPECT_EQ(2, pool.max_queued_tasks);
+
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> blocking_started{false};
+    mdl::future<void> blocker = pool.async([opened, &blocking_started]()
+        {
+            blocking_started = true;
+            opened.wait();
+        });
+    while (!blocking_started)
+        std::this_thread::yield();
+    EXPECT_EQ(0, pool.get_awaiting_tasks());
+
+    mdl::future<int> first = pool.try_async(add, 1, 2);
+    mdl::future<int> second = pool.try_async_for(std::chrono::milliseconds(10), add, 3, 4);
+    EXPECT_TRUE(first.valid());
+    EXPECT_TRUE(second.valid());
+    EXPECT_EQ(2, pool.get_awaiting_tasks());
+    EXPECT_FALSE(pool.try_async(add, 5, 6).valid());
+    EXPECT_FALSE(pool.try_async_for(std::chrono::milliseconds(20), add, 5, 6).valid());
+
+    // A blocked producer gets through once the worker picks up the queued tasks
+    std::thread producer([&pool]()
+        {
+            EXPECT_EQ(11, pool.async(add, 5, 6).get());
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.set_value();
+    producer.join();
+    blocker.get();
+    EXPECT_EQ(3, first.get());
+    EXPECT_EQ(7, second.get());
+
+    pool.max_queued_tasks = 0;
+    multiple_add_test<100>(pool);
+}
+
+TEST_F(ThreadPoolTest, BoundedQueueRoundRobin)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::round_robin);
+    bounded_queue_test(pool);
+}
+
+TEST_F(ThreadPoolTest, BoundedQueueDynamic)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    bounded_queue_test(pool);
+}
+
+TEST_F(ThreadPoolTest, BoundedQueueWorkStealing)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    bounded_queue_test(pool);
+}
+
+void priority_test(mdl::thread_pool &pool, bool keeps_order = true)
+{
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<bool> blocking_started{false};
+    mdl::future<void> blocker = pool.async([opened, &blocking_started]()
+        {
+            blocking_started = true;
+            opened.wait();
+        });
+    while (!blocking_started)
+        std::this_thread::yield();
+
+    // The single worker is busy, so all the tasks below wait in the queues
+    std::vector<int> order;
+    std::vector<mdl::future<void>> done;
+    for (int i = 0; i < 4; ++i)
+        done.push_back(pool.async(mdl::priority::bulk, [&order]() { order.push_back(2); }));
+    done.push_back(pool.async([&order]() { order.push_back(1); }));
+    done.push_back(pool.async(mdl::priority::critical, [&order]() { order.push_back(0); }));
+    gate.set_value();
+    blocker.get();
+    for (auto &f : done)
+        f.get();
+
+    ASSERT_EQ(6, order.size());
+    EXPECT_EQ(0, order.front());
+    if (keeps_order)
+    {
+        EXPECT_EQ(2, order.back());
+    }
+}
+
+TEST_F(ThreadPoolTest, PriorityRoundRobin)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::round_robin);
+    priority_test(pool);
+}
+
+TEST_F(ThreadPoolTest, PriorityDynamic)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    priority_test(pool);
+}
+
+TEST_F(ThreadPoolTest, PriorityWorkStealing)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    // Non-critical tasks lose their priority once moved to the deque
+    priority_test(pool, false);
+}
+
+void bulk_test(mdl::thread_pool &pool, bool nested = false)
+{
+    std::vector<mdl::future<int>> results = pool.async_bulk(mdl::range<int>(1000), addc<5>);
+    ASSERT_EQ(1000, results.size());
+    for (int i : mdl::range<int>(1000))
+        EXPECT_EQ(i + 5, results[i].get());
+
+    // Tasks submitted (and waited for) from a worker
+    if (nested)
+    {
+        std::vector<int> values(100);
+        std::iota(values.begin(), values.end(), 0);
+        mdl::future<int> sum = pool.async([&pool, &values]()
+            {
+                int result = 0;
+                for (auto &f : pool.async_bulk(values.begin(), values.end(), addc<1>, mdl::priority::bulk))
+                    result += f.get();
+                return result;
+            });
+        EXPECT_EQ(5050, sum.get());
+    }
+
+    // Batches larger than the bound on the queued tasks
+    pool.max_queued_tasks = 8;
+    results = pool.async_bulk(mdl::range<int>(100), addc<2>);
+    for (int i : mdl::range<int>(100))
+        EXPECT_EQ(i + 2, results[i].get());
+    pool.max_queued_tasks = 0;
+}
+
+TEST_F(ThreadPoolTest, BulkRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    bulk_test(pool);
+}
+
+TEST_F(ThreadPoolTest, BulkDynamic)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    bulk_test(pool, true);
+}
+
+TEST_F(ThreadPoolTest, BulkP2C)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::power2choices);
+    bulk_test(pool);
+}
+
+TEST_F(ThreadPoolTest, BulkWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    bulk_test(pool, true);
+}
+
+void drain_test(mdl::thread_pool &pool)
+{
+    std::vector<mdl::future<int>> results;
+    for (int i : mdl::range<int>(200))
+        results.push_back(pool.async(add, i, 1));
+    pool.shutdown(mdl::thread_pool::shutdown_mode::drain);
+    for (int i : mdl::range<int>(200))
+    {
+        ASSERT_TRUE(results[i].is_ready());
+        EXPECT_EQ(i + 1, results[i].get());
+    }
+    // Shutting down again (e.g. in the destructor) has no effect
+    pool.shutdown();
+}
+
+TEST_F(ThreadPoolTest, DrainRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    drain_test(pool);
+}
+
+TEST_F(ThreadPoolTest, DrainDynamic)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    drain_test(pool);
+}
+
+TEST_F(ThreadPoolTest, DrainWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    drain_test(pool);
+}
+
+// Submit a task blocking the only worker until the gate opens, and n more tasks queued behind it.
+mdl::future<void> block_worker(mdl::thread_pool &pool, std::shared_future<void> opened,
+                               std::vector<mdl::future<int>> &queued, int n)
+{
+    std::atomic<bool> blocking_started{false};
+    mdl::future<void> blocker = pool.async([opened, &blocking_started]()
+        {
+            blocking_started = true;
+            opened.wait();
+        });
+    while (!blocking_started)
+        std::this_thread::yield();
+    for (int i : mdl::range<int>(n))
+        queued.push_back(pool.async(add, i, 1));
+    return blocker;
+}
+
+void cancel_test(mdl::thread_pool &pool)
+{
+    std::promise<void> gate;
+    std::vector<mdl::future<int>> queued;
+    mdl::future<void> blocker = block_worker(pool, gate.get_future().share(), queued, 10);
+    std::thread opener([&gate]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            gate.set_value();
+        });
+    pool.shutdown(mdl::thread_pool::shutdown_mode::cancel_pending);
+    opener.join();
+
+    // The running task is finished, the pending ones are dropped
+    EXPECT_NO_THROW(blocker.get());
+    for (auto &result : queued)
+        EXPECT_THROW(result.get(), std::future_error);
+}
+
+TEST_F(ThreadPoolTest, CancelRoundRobin)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::round_robin);
+    cancel_test(pool);
+}
+
+TEST_F(ThreadPoolTest, CancelDynamic)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    cancel_test(pool);
+}
+
+TEST_F(ThreadPoolTest, CancelWorkStealing)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    cancel_test(pool);
+}
+
+void cancellation_test(mdl::thread_pool &pool)
+{
+    std::promise<void> gate;
+    std::vector<mdl::future<int>> queued;
+    mdl::future<void> blocker = block_worker(pool, gate.get_future().share(), queued, 0);
+
+    mdl::cancellation_source source;
+    std::vector<mdl::future<int>> cancelled;
+    for (int i : mdl::range<int>(10))
+        cancelled.push_back(pool.async(source.token(), add, i, 1));
+    mdl::future<int> kept = pool.async(mdl::cancellation_token(), add, 1, 2);
+    source.cancel();
+    gate.set_value();
+
+    // The queued tasks are dropped, while the ones without the token still run
+    EXPECT_NO_THROW(blocker.get());
+    for (auto &result : cancelled)
+        EXPECT_THROW(result.get(), mdl::operation_cancelled_exception);
+    EXPECT_EQ(3, kept.get());
+
+    // A running task may poll its token
+    mdl::cancellation_source running;
+    mdl::cancellation_token token = running.token();
+    std::atomic<bool> started{false};
+    mdl::future<int> polling = pool.async(token, [token, &started]()
+        {
+            started = true;
+            while (true)
+            {
+                token.throw_if_cancelled();
+                std::this_thread::yield();
+            }
+            return 0;
+        });
+    while (!started)
+        std::this_thread::yield();
+    running.cancel();
+    EXPECT_THROW(polling.get(), mdl::operation_cancelled_exception);
+}
+
+TEST_F(ThreadPoolTest, CancellationRoundRobin)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::round_robin);
+    cancellation_test(pool);
+}
+
+TEST_F(ThreadPoolTest, CancellationDynamic)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    cancellation_test(pool);
+}
+
+TEST_F(ThreadPoolTest, CancellationWorkStealing)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::work_stealing);
+    cancellation_test(pool);
+}
+
+TEST_F(ThreadPoolTest, MapCancellation)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    std::vector<int> input(100), output(100, -1);
+    std::iota(input.begin(), input.end(), 0);
+    {
+        std::promise<void> gate;
+        std::vector<mdl::future<int>> queued;
+        mdl::future<void> blocker = block_worker(pool, gate.get_future().share(), queued, 0);
+        mdl::cancellation_source source;
+        mdl::future<void> mapped = pool.map(input.begin(), input.end(), output.begin(),
+                                            [](int x) { return x * 2; }, source.token());
+        source.cancel();
+        gate.set_value();
+        blocker.get();
+        EXPECT_THROW(mapped.get(), mdl::operation_cancelled_exception);
+        for (int x : output)
+            EXPECT_EQ(-1, x);
+    }
+    {
+        mdl::cancellation_source source;
+        pool.map(input.begin(), input.end(), output.begin(), [](int x) { return x * 2; }, source.token()).get();
+        for (int i : mdl::range<int>(100))
+            EXPECT_EQ(2 * i, output[i]);
+    }
+}
+
+TEST_F(ThreadPoolTest, ShutdownUntil)
+{
+    {
+        mdl::thread_pool pool(1, mdl::thread_pool::strategy::round_robin);
+        std::promise<void> gate;
+        std::vector<mdl::future<int>> queued;
+        mdl::future<void> blocker = block_worker(pool, gate.get_future().share(), queued, 10);
+        std::thread opener([&gate]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                gate.set_value();
+            });
+        EXPECT_FALSE(pool.shutdown_until(mdl::helper::delay_by(std::chrono::milliseconds(10))));
+        opener.join();
+        EXPECT_NO_THROW(blocker.get());
+        for (auto &result : queued)
+            EXPECT_THROW(result.get(), std::future_error);
+    }
+    {
+        mdl::thread_pool pool(2, mdl::thread_pool::strategy::dynamic);
+        mdl::future<int> result = pool.async(add, 1, 2);
+        EXPECT_TRUE(pool.shutdown_until(mdl::helper::delay_by(std::chrono::seconds(10))));
+        EXPECT_EQ(3, result.get());
+    }
+}
+
+TEST_F(ThreadPoolTest, FastTeardown)
+{
+    auto fastest = std::chrono::steady_clock::duration::max();
+    for (int i = 0; i < 5; ++i)
+    {
+        std::unique_ptr<mdl::thread_pool> pool(new mdl::thread_pool(8, mdl::thread_pool::strategy::work_stealing));
+        simple_add_test(*pool);
+        auto start = std::chrono::steady_clock::now();
+        pool.reset();
+        fastest = std::min(fastest, std::chrono::steady_clock::now() - start);
+    }
+    // Joining on notifications: polling every 10 ms for each of the workers in turn would take at least 80 ms on
+    // every teardown, while the fastest of a few is unaffected by the occasional scheduling delay
+    EXPECT_LT(fastest, std::chrono::milliseconds(40));
+}
+
+// Wait up to a second for the condition to hold.
+template<typename Predicate>
+bool eventually(Predicate condition)
+{
+    for (int attempt = 0; attempt < 1000 && !condition(); ++attempt)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return condition();
+}
+
+TEST_F(ThreadPoolTest, ElasticWorkers)
+{
+    mdl::thread_pool pool(1, 4, std::chrono::milliseconds(20));
+    EXPECT_EQ(4, pool.workers);
+    EXPECT_EQ(1, pool.active_workers());
+
+    // Blocking tasks make the pool grow up to the maximum
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic<int> started{0};
+    std::vector<mdl::future<void>> blockers;
+    for (int i = 0; i < 5; ++i)
+        blockers.push_back(pool.async([opened, &started]()
+            {
+                ++started;
+                opened.wait();
+            }));
+    EXPECT_TRUE(eventually([&started]() { return started.load() == 4; }));
+    EXPECT_EQ(4, pool.active_workers());
+    gate.set_value();
+    for (auto &blocker : blockers)
+        blocker.get();
+    EXPECT_EQ(5, started.load());
+
+    // Idle workers are retired down to the minimum, and started again when needed
+    EXPECT_TRUE(eventually([&pool]() { return pool.active_workers() == 1; }));
+    multiple_add_test<100>(pool);
+}
+
+TEST_F(ThreadPoolTest, ElasticFromZero)
+{
+    mdl::thread_pool pool(0, 2, std::chrono::milliseconds(10));
+    EXPECT_EQ(0, pool.active_workers());
+    simple_add_test(pool);
+    EXPECT_TRUE(eventually([&pool]() { return pool.active_workers() == 0; }));
+    simple_add_test(pool);
+    std::vector<int> a(1000, 1), b(1000);
+    pool.map(a.begin(), a.end(), b.begin(), [](int x) { return x + 1; }).get();
+    EXPECT_EQ(2, b[999]);
+}
+
+// CPU time consumed so far by the other threads of the process (i.e. the workers), but not by the calling thread.
+double workers_cpu_ms()
+{
+    timespec process, thread;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &process);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread);
+    return (process.tv_sec - thread.tv_sec) * 1000.0 + (process.tv_nsec - thread.tv_nsec) / 1000000.0;
+}
+
+void idle_cpu_test(mdl::thread_pool &pool)
+{
+    simple_add_test(pool);
+    double start_ms = workers_cpu_ms();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    double cpu_ms = workers_cpu_ms() - start_ms;
+    // Parked workers should not consume any noticeable CPU time, while a single spinning one would take most of it
+    EXPECT_LT(cpu_ms, 250.0);
+    simple_add_test(pool);
+}
+
+TEST_F(ThreadPoolTest, IdleRoundRobin)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::round_robin);
+    idle_cpu_test(pool);
+}
+
+TEST_F(ThreadPoolTest, IdleDynamic)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::dynamic);
+    idle_cpu_test(pool);
+}
+
+TEST_F(ThreadPoolTest, IdleWorkStealing)
+{
+    mdl::thread_pool pool(4, mdl::thread_pool::strategy::work_stealing);
+    pool.idle_spins = 0;
+    EXPECT_EQ(0, pool.idle_spins);
+    idle_cpu_test(pool);
+}
+
+void metrics_test(mdl::thread_pool &pool)
+{
+    const uint64_t n = 100 + pool.metrics().total().tasks_executed;
+    std::vector<mdl::future<int>> results;
+    for (int i : mdl::range<int>(100))
+        results.push_back(pool.async(add, i, 1));
+    for (auto &result : results)
+        result.get();
+
+    // The counters are updated right after the futures are fulfilled
+    EXPECT_TRUE(eventually([&pool, n]() { return pool.metrics().total().tasks_executed == n; }));
+    mdl::thread_pool_metrics metrics = pool.metrics();
+    EXPECT_EQ(pool.workers, metrics.workers.size());
+    mdl::looper_metrics total = metrics.total();
+    uint64_t histogram_total = 0;
+    for (uint64_t bucket : total.task_times)
+        histogram_total += bucket;
+    EXPECT_EQ(n, histogram_total);
+    EXPECT_GE(total.messages_handled, 1);
+}
+
+TEST_F(ThreadPoolTest, MetricsRoundRobin)
+{
+    mdl::thread_pool pool(2, mdl::thread_pool::strategy::round_robin);
+    metrics_test(pool);
+    EXPECT_EQ(0, pool.metrics().total().steals);
+}
+
+TEST_F(ThreadPoolTest, MetricsDynamic)
+{
+    mdl::thread_pool pool(1, mdl::thread_pool::strategy::dynamic);
+    std::promise<void> gate;
+    std::vector<mdl::future<int>> queued;
+    mdl::future<void> blocker = block_worker(pool, gate.get_future().share(), queued, 10);
+    EXPECT_GE(pool.metrics().shared_queue_high_water, 10);
+    gate.set_value();
+    blocker.get();
+    for (auto &result : queued)
+        result.get();
+    EXPECT_TRUE(eventually([&pool]() { return pool.metrics().total().tasks_executed == 11; }));
+    metrics_test(pool);
+}
+
+TEST_F(ThreadPoolTest, MetricsWorkStealing)
+{
+    mdl::thread_pool pool(2, mdl::thread_pool::strategy::work_stealing);
+    metrics_test(pool);
+}
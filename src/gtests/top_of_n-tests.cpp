@@ -0,0 +1,77 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/algorithms.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    std::vector<int> random_scores(size_t n, unsigned seed)
+    {
+        std::vector<int> scores(n);
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> dist(0, 1000000);
+        for (auto &score : scores)
+            score = dist(rng);
+        return scores;
+    }
+
+    template<typename Compare>
+    void expect_top(const std::vector<int> &scores,
+                    const std::vector<std::reference_wrapper<const int>> &top, size_t k, Compare comp)
+    {
+        std::vector<int> expected(scores);
+        std::partial_sort(expected.begin(), expected.begin() + k, expected.end(), comp);
+        ASSERT_EQ(k, top.size());
+        for (size_t i = 0; i < k; ++i)
+            EXPECT_EQ(expected[i], top[i].get());
+    }
+}
+
+TEST(TopOfNTest, ParallelMatchesSequential)
+{
+    mdl::thread_pool pool(4);
+    const std::vector<int> scores = random_scores(100000, 7);
+    for (size_t k : {1, 10, 100, 1000})
+    {
+        expect_top(scores, mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), k, std::greater<int>()), k,
+                   std::greater<int>());
+        expect_top(scores, mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), k, std::less<int>()), k,
+                   std::less<int>());
+    }
+}
+
+TEST(TopOfNTest, ParallelReferencesInput)
+{
+    mdl::thread_pool pool(2);
+    std::vector<int> scores = random_scores(1000, 11);
+    auto top = mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), 5, std::greater<int>());
+    // The results refer to the elements of the range itself
+    for (auto &ref : top)
+    {
+        EXPECT_GE(&ref.get(), &scores.front());
+        EXPECT_LE(&ref.get(), &scores.back());
+    }
+}
+
+TEST(TopOfNTest, ParallelEdgeCases)
+{
+    mdl::thread_pool pool(3);
+    const std::vector<int> scores = {5, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    // The whole range, fewer elements than chunks, nothing
+    expect_top(scores, mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), scores.size(), std::greater<int>()),
+               scores.size(), std::greater<int>());
+    const std::vector<int> pair(scores.begin(), scores.begin() + 2);
+    expect_top(pair, mdl::parallel_top_of_n(pool, pair.begin(), pair.end(), 2, std::greater<int>()), 2,
+               std::greater<int>());
+    EXPECT_TRUE(mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), 0, std::greater<int>()).empty());
+    EXPECT_THROW(mdl::parallel_top_of_n(pool, scores.begin(), scores.end(), 11, std::greater<int>()),
+                 mdl::invalid_argument_exception<size_t>);
+}
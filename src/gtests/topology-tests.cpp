@@ -0,0 +1,71 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/topology.hpp>
+#include <mdlutils/multithreading/thread_pool.hpp>
+
+class TopologyTest : public ::testing::Test
+{
+protected:
+    // 2 packages x 2 cores x 2 hardware threads, numbered the way Linux usually does (siblings are n and n + 4)
+    std::vector<mdl::cpu_info> cpus = {
+            {0, 0, 0, 0}, {1, 0, 1, 0}, {2, 1, 0, 1}, {3, 1, 1, 1},
+            {4, 0, 0, 0}, {5, 0, 1, 0}, {6, 1, 0, 1}, {7, 1, 1, 1}
+    };
+};
+
+TEST_F(TopologyTest, NoPlacement)
+{
+    EXPECT_EQ(std::vector<int>(3, -1), mdl::helper::plan_placement(cpus, mdl::placement_policy::none, 3));
+    EXPECT_EQ(std::vector<int>(2, -1), mdl::helper::plan_placement({}, mdl::placement_policy::compact, 2));
+}
+
+TEST_F(TopologyTest, Compact)
+{
+    std::vector<int> expected = {0, 4, 1, 5, 2, 6};
+    EXPECT_EQ(expected, mdl::helper::plan_placement(cpus, mdl::placement_policy::compact, 6));
+}
+
+TEST_F(TopologyTest, Scatter)
+{
+    std::vector<int> expected = {0, 2, 1, 3, 4, 6};
+    EXPECT_EQ(expected, mdl::helper::plan_placement(cpus, mdl::placement_policy::scatter, 6));
+}
+
+TEST_F(TopologyTest, PhysicalCores)
+{
+    std::vector<int> expected = {0, 1, 2, 3, 0, 1};
+    EXPECT_EQ(expected, mdl::helper::plan_placement(cpus, mdl::placement_policy::physical_cores, 6));
+}
+
+TEST_F(TopologyTest, PinnedPool)
+{
+    std::vector<mdl::cpu_info> available = mdl::helper::cpu_topology();
+    mdl::thread_pool pool(2, mdl::thread_pool::strategy::work_stealing, mdl::placement_policy::compact);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        if (available.empty())
+            EXPECT_EQ(-1, pool.worker_cpu(i));
+        else
+            EXPECT_LE(0, pool.worker_cpu(i));
+    }
+    EXPECT_EQ(5, pool.async([]() { return 2 + 3; }).get());
+}
+
+TEST_F(TopologyTest, PinnedElasticPool)
+{
+    mdl::thread_pool pool(0, 2, std::chrono::milliseconds(1), mdl::placement_policy::compact);
+    // Workers retired and started again are pinned again, but keep their relocated deques
+    for (int i = 0; i < 20; ++i)
+    {
+        EXPECT_EQ(i, pool.async([i]() { return i; }).get());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
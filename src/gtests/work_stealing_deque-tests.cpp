@@ -0,0 +1,109 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include <mdlutils/multithreading/work_stealing_deque.hpp>
+#include <mdlutils/types/range.hpp>
+
+class WorkStealingDequeTest : public ::testing::Test
+{
+protected:
+    mdl::work_stealing_deque<size_t> deque{4};
+};
+
+TEST_F(WorkStealingDequeTest, EmptyDeque)
+{
+    size_t value;
+    EXPECT_TRUE(deque.empty());
+    EXPECT_FALSE(deque.pop(value));
+    EXPECT_FALSE(deque.steal(value));
+}
+
+TEST_F(WorkStealingDequeTest, PopIsLIFO)
+{
+    for (size_t i : mdl::range<size_t>(3))
+        deque.push(i);
+    size_t value;
+    for (int i : mdl::range<int>(2, -1, -1))
+    {
+        ASSERT_TRUE(deque.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(deque.pop(value));
+}
+
+TEST_F(WorkStealingDequeTest, StealIsFIFO)
+{
+    for (size_t i : mdl::range<size_t>(3))
+        deque.push(i);
+    size_t value;
+    for (size_t i : mdl::range<size_t>(3))
+    {
+        ASSERT_TRUE(deque.steal(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(deque.steal(value));
+}
+
+TEST_F(WorkStealingDequeTest, Grow)
+{
+    for (size_t i : mdl::range<size_t>(100))
+        deque.push(i);
+    EXPECT_EQ(100, deque.size());
+    size_t value;
+    ASSERT_TRUE(deque.steal(value));
+    EXPECT_EQ(0, value);
+    ASSERT_TRUE(deque.pop(value));
+    EXPECT_EQ(99, value);
+    EXPECT_EQ(98, deque.size());
+}
+
+TEST_F(WorkStealingDequeTest, ConcurrentSteal)
+{
+    const size_t n = 100000;
+    std::atomic<size_t> taken{0}, sum{0};
+    std::atomic_bool done{false};
+
+    std::vector<std::thread> thieves;
+    for (size_t t = 0; t < 3; ++t)
+        thieves.emplace_back([&]()
+                                 {
+                                     size_t value;
+                                     while (!done.load() || !deque.empty())
+                                         if (deque.steal(value))
+                                         {
+                                             sum += value;
+                                             ++taken;
+                                         }
+                                         else
+                                             std::this_thread::yield();
+                                 });
+
+    size_t value;
+    for (size_t i : mdl::range<size_t>(1, n + 1))
+    {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(value))
+        {
+            sum += value;
+            ++taken;
+        }
+    }
+    done.store(true);
+    for (auto &thief : thieves)
+        thief.join();
+    while (deque.pop(value))
+    {
+        sum += value;
+        ++taken;
+    }
+
+    EXPECT_EQ(n, taken.load());
+    EXPECT_EQ(n * (n + 1) / 2, sum.load());
+}
@@ -0,0 +1,111 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/memory/arena_allocator.hpp>
+
+namespace mdl
+{
+    namespace
+    {
+        // Space before the first block of a chunk, keeping the blocks aligned.
+        const size_t chunk_header = (sizeof(void *) * 2 + arena::block_alignment - 1) / arena::block_alignment *
+                                    arena::block_alignment;
+    }
+
+    const size_t arena::block_alignment;
+    const size_t arena::max_block_size;
+    const size_t arena::default_chunk_size;
+    const size_t arena::size_classes;
+
+    void arena::grow(size_t bytes)
+    {
+        size_t size = chunk_size > chunk_header + bytes ? chunk_size : chunk_header + bytes;
+        chunk *fresh = static_cast<chunk *>(::operator new(size));
+        fresh->next = chunks;
+        fresh->size = size;
+        chunks = fresh;
+        cursor = reinterpret_cast<char *>(fresh) + chunk_header;
+        limit = reinterpret_cast<char *>(fresh) + size;
+    }
+
+    void arena::reset()
+    {
+        for (auto &list : free_lists)
+            list = nullptr;
+        if (chunks == nullptr)
+            return;
+        chunk *keep = chunks;
+        for (chunk *it = keep->next; it != nullptr;)
+        {
+            chunk *next = it->next;
+            ::operator delete(it);
+            it = next;
+        }
+        keep->next = nullptr;
+        cursor = reinterpret_cast<char *>(keep) + chunk_header;
+        limit = reinterpret_cast<char *>(keep) + keep->size;
+    }
+
+    void *arena::allocate(size_t bytes)
+    {
+        if (bytes > max_block_size)
+            return ::operator new(bytes);
+
+        const size_t size_class = bytes ? (bytes - 1) / block_alignment : 0;
+        void *block = free_lists[size_class];
+        if (block != nullptr)
+            free_lists[size_class] = free_lists[size_class]->next;
+        else
+        {
+            const size_t size = (size_class + 1) * block_alignment;
+            if (static_cast<size_t>(limit - cursor) < size)
+                grow(size);
+            block = cursor;
+            cursor += size;
+        }
+        ++live;
+        return block;
+    }
+
+    void arena::deallocate(void *block, size_t bytes)
+    {
+        if (block == nullptr)
+            return;
+        if (bytes > max_block_size)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        const size_t size_class = bytes ? (bytes - 1) / block_alignment : 0;
+        free_block *freed = static_cast<free_block *>(block);
+        freed->next = free_lists[size_class];
+        free_lists[size_class] = freed;
+        if (--live == 0)
+            reset();
+    }
+
+    void arena::release()
+    {
+        for (chunk *it = chunks; it != nullptr;)
+        {
+            chunk *next = it->next;
+            ::operator delete(it);
+            it = next;
+        }
+        chunks = nullptr;
+        cursor = limit = nullptr;
+        for (auto &list : free_lists)
+            list = nullptr;
+        live = 0;
+    }
+
+    size_t arena::capacity() const
+    {
+        size_t total = 0;
+        for (chunk *it = chunks; it != nullptr; it = it->next)
+            total += it->size;
+        return total;
+    }
+}
@@ -0,0 +1,180 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mutex>
+#include <atomic>
+
+#include <mdlutils/memory/pool_allocator.hpp>
+
+namespace mdl
+{
+    namespace helper
+    {
+        namespace
+        {
+            // Every block is preceded by a header holding the pointer to its owning heap (nullptr if none).
+            const size_t header_size = block_pool::block_alignment;
+            const size_t size_classes = block_pool::max_block_size / block_pool::block_alignment;
+
+            // Free blocks are linked through their first bytes.
+            struct free_block
+            {
+                free_block *next;
+            };
+
+            // Per-thread set of free lists, one for each size class.
+            struct thread_heap
+            {
+                // Blocks available to the owner thread.
+                free_block *local[size_classes];
+                // Blocks returned by other threads, taken over by the owner in one exchange.
+                std::atomic<free_block *> remote[size_classes];
+                // Link in the list of abandoned heaps.
+                thread_heap *next_abandoned;
+
+                thread_heap() : next_abandoned(nullptr)
+                {
+                    for (size_t i = 0; i < size_classes; ++i)
+                    {
+                        local[i] = nullptr;
+                        remote[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+            };
+
+            // Heaps of the threads that have exited, waiting to be adopted.
+            std::mutex abandoned_lock;
+            thread_heap *abandoned = nullptr;
+
+            // Heap of the current thread, nullptr before the first use and after the thread's storage is released.
+            thread_local thread_heap *current_heap = nullptr;
+            thread_local bool heap_released = false;
+
+            thread_heap *&owner_of(void *block)
+            {
+                return *reinterpret_cast<thread_heap **>(static_cast<char *>(block) - header_size);
+            }
+
+            thread_heap *adopt_heap()
+            {
+                {
+                    std::lock_guard<std::mutex> scope_lock(abandoned_lock);
+                    if (abandoned != nullptr)
+                    {
+                        thread_heap *heap = abandoned;
+                        abandoned = heap->next_abandoned;
+                        heap->next_abandoned = nullptr;
+                        return heap;
+                    }
+                }
+                return new thread_heap();
+            }
+
+            void abandon_heap(thread_heap *heap)
+            {
+                std::lock_guard<std::mutex> scope_lock(abandoned_lock);
+                heap->next_abandoned = abandoned;
+                abandoned = heap;
+            }
+
+            // Hands the heap over to the abandoned list, once the thread exits.
+            struct heap_releaser
+            {
+                ~heap_releaser()
+                {
+                    heap_released = true;
+                    if (current_heap != nullptr)
+                        abandon_heap(current_heap);
+                    current_heap = nullptr;
+                }
+            };
+
+            thread_heap *local_heap()
+            {
+                if (current_heap != nullptr || heap_released)
+                    return current_heap;
+                static thread_local heap_releaser releaser;
+                (void) releaser;
+                current_heap = adopt_heap();
+                return current_heap;
+            }
+
+            // Carve a new slab into free blocks of the given size class, owned by heap.
+            free_block *refill(thread_heap *heap, size_t size_class)
+            {
+                const size_t stride = header_size + (size_class + 1) * block_pool::block_alignment;
+                char *slab = static_cast<char *>(::operator new(stride * block_pool::blocks_per_slab));
+                free_block *first = nullptr;
+                for (size_t i = block_pool::blocks_per_slab; i-- > 0;)
+                {
+                    free_block *block = reinterpret_cast<free_block *>(slab + i * stride + header_size);
+                    owner_of(block) = heap;
+                    block->next = first;
+                    first = block;
+                }
+                return first;
+            }
+        }
+
+        const size_t block_pool::block_alignment;
+        const size_t block_pool::max_block_size;
+        const size_t block_pool::blocks_per_slab;
+
+        void *block_pool::allocate(size_t bytes)
+        {
+            if (bytes > max_block_size)
+                return ::operator new(bytes);
+
+            const size_t size_class = bytes ? (bytes - 1) / block_alignment : 0;
+            thread_heap *heap = local_heap();
+            if (heap == nullptr) // the thread is exiting, allocate an unowned block
+            {
+                void *block = static_cast<char *>(::operator new(header_size + bytes)) + header_size;
+                owner_of(block) = nullptr;
+                return block;
+            }
+
+            free_block *block = heap->local[size_class];
+            if (block == nullptr)
+                block = heap->remote[size_class].exchange(nullptr, std::memory_order_acquire);
+            if (block == nullptr)
+                block = refill(heap, size_class);
+            heap->local[size_class] = block->next;
+            return block;
+        }
+
+        void block_pool::deallocate(void *block, size_t bytes)
+        {
+            if (block == nullptr)
+                return;
+            if (bytes > max_block_size)
+            {
+                ::operator delete(block);
+                return;
+            }
+
+            thread_heap *owner = owner_of(block);
+            if (owner == nullptr)
+            {
+                ::operator delete(static_cast<char *>(block) - header_size);
+                return;
+            }
+
+            const size_t size_class = bytes ? (bytes - 1) / block_alignment : 0;
+            free_block *freed = static_cast<free_block *>(block);
+            if (owner == local_heap())
+            {
+                freed->next = owner->local[size_class];
+                owner->local[size_class] = freed;
+                return;
+            }
+
+            // Return the block to the owner's remote stack
+            std::atomic<free_block *> &remote = owner->remote[size_class];
+            freed->next = remote.load(std::memory_order_relaxed);
+            while (!remote.compare_exchange_weak(freed->next, freed, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        }
+    }
+}
@@ -3,6 +3,7 @@
 //
 
 #include <mdlutils/multithreading/handler.hpp>
+#include <mdlutils/multithreading/metrics.hpp>
 #include <mdlutils/exceptions/break_out_exception.hpp>
 #include <mdlutils/exceptions/not_implemented_exception.hpp>
 
@@ -10,13 +11,15 @@ namespace mdl
 {
     bool executor_handler::handle_message(message_ptr msg)
     {
-        auto msg_post = std::dynamic_pointer_cast<post_call>(msg);
-        if (msg_post)
+        if (is_message<post_call>(msg))
         {
+            post_call *msg_post = static_cast<post_call *>(msg.get());
             // invoke the function
-            msg_post->function();
+            {
+                helper::task_timer timer;
+                msg_post->function();
+            }
             msg_post->function = nullptr;
-            msg_post = nullptr;
             return true;
         }
         return false;
@@ -24,24 +27,36 @@ namespace mdl
 
     bool delaying_handler::handle_message(message_ptr msg)
     {
-        auto msg_delay = std::dynamic_pointer_cast<delayed_message>(msg);
-        if (msg_delay)
+        if (is_message<delayed_message>(msg))
         {
+            delayed_message *msg_delay = static_cast<delayed_message *>(msg.get());
             // If it's already after msg->delayed_until, push the content of the message
             if(helper::is_after(msg_delay->delayed_until))
                 queue.push(msg_delay->content);
-            // Repush delayed message otherwise
+            // Keep it until the deadline otherwise
             else
-                queue.push(msg_delay);
+                timers.push(timer{msg_delay->delayed_until, next_sequence++, msg_delay->content});
             return true;
         }
         return false;
     }
 
+    time_point_t delaying_handler::release_due()
+    {
+        if (timers.empty())
+            return time_point_t::max();
+        time_point_t now = std::chrono::high_resolution_clock::now();
+        while (!timers.empty() && timers.top().deadline <= now)
+        {
+            queue.push(timers.top().content);
+            timers.pop();
+        }
+        return timers.empty() ? time_point_t::max() : timers.top().deadline;
+    }
+
     bool break_handler::handle_message(message_ptr msg)
     {
-        auto msg_break = std::dynamic_pointer_cast<break_message>(msg);
-        if (msg_break)
+        if (is_message<break_message>(msg))
         {
             throw break_out_exception{}; // We don't use mdl_throw here, since we don't want it's mechanics.
         }
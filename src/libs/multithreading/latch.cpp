@@ -0,0 +1,26 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/multithreading/latch.hpp>
+
+namespace mdl
+{
+    void latch::count_down(ptrdiff_t n)
+    {
+        if (counter.fetch_sub(n, std::memory_order_acq_rel) == n)
+        {
+            // Lock, so that a thread between checking the counter and starting to wait won't miss the notification
+            std::lock_guard<std::mutex> scope_lock(lock);
+            released.notify_all();
+        }
+    }
+
+    void latch::wait()
+    {
+        if (try_wait())
+            return;
+        std::unique_lock<std::mutex> scope_lock(lock);
+        released.wait(scope_lock, [this]() { return try_wait(); });
+    }
+}
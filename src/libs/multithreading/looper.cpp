@@ -5,6 +5,8 @@
 #include <mdlutils/multithreading/looper.hpp>
 #include <mdlutils/exceptions/break_out_exception.hpp>
 
+#include <algorithm>
+
 namespace mdl
 {
     void looper_base::loop()
@@ -14,38 +16,39 @@ namespace mdl
             mdl_throw(invalid_state_exception<decltype(*this)>, "Looper already running", *this);
 
         is_running.store(true);
-        is_started.store(true);
         is_stopped.store(false);
+        {
+            mutex_lock scope_lock(state_lock);
+            is_started.store(true);
+            state_cv.notify_all();
+        }
 
         //std::cout << "Loop marked as started and running" << std::endl;
+        helper::scheduler_counters::attach(&counters);
 
         try
         {
             while (is_running.load())
             {
-                bool queue_empty;
-                {
-                    mutex_lock scope_lock(message_queue_lock);
-                    queue_empty = message_queue.empty();
-                }
-                if (queue_empty)// wait until there is a job in the queue
-                {
-                    std::this_thread::yield();
+                if (!wait_for_message()) // wait until there is a job in the queue
                     continue;
-                }
 
                 is_processing.store(true); // mark yourself as currently processing
+                counters.record_depth(count());
 
                 message_ptr message;
+                bool handled = false;
+                time_point_t start;
+                duration_t idle_before;
                 try
                 {
+                    if (pop_message(message))
                     {
-                        mutex_lock scope_lock(message_queue_lock);
-                        message = message_queue.front();
-                        message_queue.pop();
+                        handled = true;
+                        start = std::chrono::high_resolution_clock::now();
+                        idle_before = counters.idle_time();
+                        sequential_handle_message(std::move(message));
                     }
-
-                    sequential_handle_message(message);
                 }
                 catch (std::exception &e)
                 {
@@ -55,6 +58,10 @@ namespace mdl
                     else
                         std::rethrow_exception(p);
                 }
+                // Handlers waiting for more work (e.g. thread_pool workers) don't count their waits as busy time
+                if (handled)
+                    counters.record_message(std::chrono::high_resolution_clock::now() - start -
+                                            (counters.idle_time() - idle_before));
 
                 is_processing.store(false);
             }
@@ -62,14 +69,116 @@ namespace mdl
         catch (break_out_exception &e)
         {
         }
+        helper::scheduler_counters::attach(nullptr);
         is_running.store(false);
+        // Notified under the lock, so that the waiters can't return (and destroy the looper) before it's done
+        mutex_lock scope_lock(state_lock);
         is_stopped.store(true);
+        state_cv.notify_all();
     }
 
     void looper_base::stop()
     {
         wait_until_started();
         is_running.store(false);
+        wake();
+    }
+
+    bool looper_base::wait_for_message()
+    {
+        return wait_for_message(time_point_t::max());
+    }
+
+    bool looper_base::wait_for_message(time_point_t limit)
+    {
+        time_point_t deadline = std::min(limit, process_timers());
+        bool timed = deadline != time_point_t::max();
+        auto woken = [&]()
+            {
+                return message_ready() || wake_pending.load() || !is_running.load();
+            };
+
+        if (!woken())
+        {
+            time_point_t idle_start = std::chrono::high_resolution_clock::now();
+            unsigned spins = spin_threshold.load();
+            for (unsigned i = 0; i < spins && !woken(); ++i)
+                std::this_thread::yield();
+
+            if (!woken() && !(timed && helper::is_after(deadline)))
+            {
+                std::unique_lock<std::mutex> scope_lock(park_lock);
+                is_parked.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (timed)
+                    message_queue_cv.wait_until(scope_lock, deadline, woken);
+                else
+                    message_queue_cv.wait(scope_lock, woken);
+                is_parked.store(false);
+                if (woken())
+                    counters.record_wakeup();
+            }
+            counters.record_idle(std::chrono::high_resolution_clock::now() - idle_start);
+        }
+        wake_pending.store(false);
+        return message_ready();
+    }
+
+    bool looper_base::pop_message(message_ptr &msg)
+    {
+        while (true)
+        {
+            size_t lane = lanes.next([&](size_t lane)
+                {
+                    // With a break pending, only the messages sent before it are taken (from the other lanes, the
+                    // ones queued when it was popped)
+                    if (deferred_break != nullptr && deferred_counts[lane] == 0)
+                        return false;
+                    return message_queues[lane].pop(msg);
+                });
+            if (lane == priority_levels)
+            {
+                if (deferred_break == nullptr)
+                    return false;
+                for (size_t count : deferred_counts)
+                    if (count)
+                        return false;
+                msg = std::move(deferred_break);
+                deferred_break = nullptr;
+                return true;
+            }
+            if (deferred_break != nullptr)
+                --deferred_counts[lane];
+            else if (is_message<break_message>(msg) && message_ready())
+            {
+                // Break out only after the messages sent before, even if they are less urgent. Whatever follows the
+                // break in its own lane has been sent after it.
+                for (size_t i = 0; i < priority_levels; ++i)
+                    deferred_counts[i] = message_queues[i].size();
+                deferred_counts[lane] = 0;
+                deferred_break = std::move(msg);
+                continue;
+            }
+            handled_priority = static_cast<priority>(lane);
+            return true;
+        }
+    }
+
+    bool looper_base::message_ready() const
+    {
+        if (deferred_break != nullptr)
+            return true;
+        for (const auto &queue : message_queues)
+            if (queue.ready())
+                return true;
+        return false;
+    }
+
+    void looper_base::wake()
+    {
+        wake_pending.store(true);
+        { mutex_lock scope_lock(park_lock); }
+        message_queue_cv.notify_one();
     }
 
     void looper_base::stop_safely()
@@ -91,33 +200,53 @@ namespace mdl
         wait_until_finished();
     }
 
+    void looper_base::build_dispatch_table(message_type max_type)
+    {
+        dispatch_table.assign(max_type + 1, std::vector<mdl::handler *>());
+        for (message_type type = 0; type <= max_type; ++type)
+            for (auto handler : handler_stack)
+                if (handler.get().accepts(type))
+                    dispatch_table[type].push_back(&handler.get());
+    }
+
     void looper_base::sequential_handle_message(message_ptr msg)
     {
-        for (auto handler : handler_stack)
-        {
-            if (handler.get().handle_message(msg))
+        message_type type = msg != nullptr ? msg->type : 0;
+        if (type >= dispatch_table.size())
+            build_dispatch_table(type);
+
+        const std::vector<mdl::handler *> &handlers = dispatch_table[type];
+        if (handlers.empty())
+            return;
+        // The last handler gets the only remaining reference to the message
+        for (size_t i = 0, last = handlers.size() - 1; i < last; ++i)
+            if (handlers[i]->handle_message(msg))
                 return;
-        }
+        handlers.back()->handle_message(std::move(msg));
     }
 
     void looper_base::wait_until_started()
     {
-        //std::cout << "Wait until started..." << std::endl;
-        while (!started)
-        {
-            std::this_thread::yield();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+        std::unique_lock<std::mutex> scope_lock(state_lock);
+        state_cv.wait(scope_lock, [this]() { return is_started.load(); });
     }
 
     void looper_base::wait_until_finished()
     {
-        //std::cout << "Wait until finished..." << std::endl;
-        while (!stopped)
+        wait_until_finished(time_point_t::max());
+    }
+
+    bool looper_base::wait_until_finished(time_point_t deadline)
+    {
         {
-            std::this_thread::yield();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::unique_lock<std::mutex> scope_lock(state_lock);
+            auto finished = [this]() { return is_stopped.load(); };
+            if (deadline == time_point_t::max())
+                state_cv.wait(scope_lock, finished);
+            else if (!state_cv.wait_until(scope_lock, deadline, finished))
+                return false;
         }
         if(thread_ref.joinable()) thread_ref.join();
+        return true;
     }
 }
\ No newline at end of file
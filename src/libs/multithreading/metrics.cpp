@@ -0,0 +1,65 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/multithreading/metrics.hpp>
+
+#include <algorithm>
+
+namespace mdl
+{
+    looper_metrics &looper_metrics::operator+=(const looper_metrics &other)
+    {
+        messages_handled += other.messages_handled;
+        tasks_executed += other.tasks_executed;
+        queue_high_water = std::max(queue_high_water, other.queue_high_water);
+        handler_time += other.handler_time;
+        idle_time += other.idle_time;
+        wakeups += other.wakeups;
+        steals += other.steals;
+        for (size_t i = 0; i < histogram_buckets; ++i)
+            task_times[i] += other.task_times[i];
+        return *this;
+    }
+
+    looper_metrics thread_pool_metrics::total() const
+    {
+        looper_metrics result;
+        for (const auto &worker : workers)
+            result += worker;
+        return result;
+    }
+
+    namespace helper
+    {
+        thread_local scheduler_counters *scheduler_counters::current_counters = nullptr;
+
+        size_t scheduler_counters::bucket_of(duration_t duration)
+        {
+            int64_t ns = nanoseconds(duration);
+            size_t bucket = 0;
+            while (ns > 1 && bucket + 1 < looper_metrics::histogram_buckets)
+            {
+                ns >>= 1;
+                ++bucket;
+            }
+            return bucket;
+        }
+
+        looper_metrics scheduler_counters::snapshot() const
+        {
+            looper_metrics result;
+            result.messages_handled = messages.load(std::memory_order_relaxed);
+            result.tasks_executed = tasks.load(std::memory_order_relaxed);
+            result.queue_high_water = high_water.load(std::memory_order_relaxed);
+            result.handler_time = std::chrono::duration_cast<duration_t>(
+                    std::chrono::nanoseconds(handler_ns.load(std::memory_order_relaxed)));
+            result.idle_time = idle_time();
+            result.wakeups = wakeups.load(std::memory_order_relaxed);
+            result.steals = steals.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < looper_metrics::histogram_buckets; ++i)
+                result.task_times[i] = task_times[i].load(std::memory_order_relaxed);
+            return result;
+        }
+    }
+}
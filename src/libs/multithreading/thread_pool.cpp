@@ -12,118 +12,615 @@ namespace mdl
     {
         unsigned queue_id;
 
-        empty_queue_guard(unsigned id) : queue_id(id) { }
+        empty_queue_guard(unsigned id) : message(message_type_id<empty_queue_guard>()), queue_id(id) { }
 
         virtual ~empty_queue_guard() { }
     };
 
+    struct placement_message : public message
+    {
+        unsigned queue_id;
+        int cpu;
+
+        placement_message(unsigned id, int cpu) : message(message_type_id<placement_message>()), queue_id(id),
+                                                  cpu(cpu) { }
+
+        virtual ~placement_message() { }
+    };
+
+    thread_local thread_pool::thread_handler *thread_pool::local_worker = nullptr;
+    thread_local const thread_pool *thread_pool::local_pool = nullptr;
+    thread_local thread_pool::thread_handler *thread_pool::running_worker = nullptr;
+
+    bool thread_pool::accepts(message_type type) const
+    {
+        if (type == message_type_id<empty_queue_guard>() || type == message_type_id<post_call>() ||
+            type == message_type_id<placement_message>())
+            return true;
+        // Under work_stealing and dynamic, the deques and the shared queues are drained before breaking out
+        return (task_assigning_strategy == strategy::work_stealing || task_assigning_strategy == strategy::dynamic) &&
+               type == message_type_id<break_message>();
+    }
+
     bool thread_pool::handle_message(message_ptr msg)
     {
-        auto msg_queue_guard = std::dynamic_pointer_cast<empty_queue_guard>(msg);
+        local_pool = this;
+        if (is_message<placement_message>(msg))
+        {
+            placement_message *msg_placement = static_cast<placement_message *>(msg.get());
+            helper::pin_current_thread(msg_placement->cpu);
+            // Reallocate the deque (on the first start only, as the old buffers are freed with the deque) and create
+            // the thread-cached pool from the pinned thread
+            thread_handler &worker = pool[msg_placement->queue_id];
+            if (!worker.tasks_relocated)
+            {
+                worker.tasks.relocate();
+                worker.tasks_relocated = true;
+            }
+            pool_allocator<message_ptr> alloc;
+            alloc.deallocate(alloc.allocate(1), 1);
+            return true;
+        }
+        empty_queue_guard *msg_queue_guard = is_message<empty_queue_guard>(msg) ?
+                                             static_cast<empty_queue_guard *>(msg.get()) : nullptr;
+        if (msg_queue_guard && task_assigning_strategy == strategy::work_stealing)
+        {
+            thread_handler &worker = pool[msg_queue_guard->queue_id];
+            local_worker = &worker;
+
+            // Run the tasks from the own deque (or stolen ones), until something new arrives in the message queue
+            bool idle = true;
+            message_ptr *task;
+            while (worker.empty() && (worker.tasks.pop(task) || steal_task(worker, task)))
+            {
+                run_task(task);
+                idle = false;
+            }
+            if (idle)
+                park_worker(worker);
+
+            // Resend empty queue guard
+            worker.send_message(msg);
+            return true;
+        }
         if (msg_queue_guard)
         {
-            if (pool[msg_queue_guard->queue_id].empty())
+            thread_handler &worker = pool[msg_queue_guard->queue_id];
+            if (worker.empty())
             {
-                // TODO: logic for empty message queue
-                if (task_assigning_strategy == strategy::dynamic)
-                {
-                    message_ptr task = nullptr;
-                    {
-                        mutex_lock scope_lock(task_queue_lock);
-                        if (!task_queue.empty())
-                        {
-                            task = task_queue.front();
-                            task_queue.pop();
-                        }
-                    }
-                    if (task != nullptr)
-                    {
-                        pool[msg_queue_guard->queue_id].send_message(task);
-                    }
-                    else
-                    {
-                        std::this_thread::yield();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                    }
-                }
-                else
-                {
-                    std::this_thread::yield();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                }
+                message_ptr task;
+                if (pop_shared_task(task))
+                    run_message(std::move(task));
+                else if (!park_worker(worker, is_elastic() ? helper::delay_by(idle_timeout) : time_point_t::max()) &&
+                         retire_worker(worker))
+                    return true;
             }
             // Resend empty queue guard
-            pool[msg_queue_guard->queue_id].send_message(msg);
+            worker.send_message(msg);
+            return true;
+        }
+        // Help running the tasks left in the shared queues before breaking out of the loop
+        if (task_assigning_strategy == strategy::dynamic && is_message<break_message>(msg))
+        {
+            message_ptr task;
+            while (pop_shared_task(task))
+                run_message(std::move(task));
+            return false;
+        }
+        if (task_assigning_strategy == strategy::work_stealing && is_local_worker())
+        {
+            // Tasks posted from outside of the pool are moved to the deque, so that they can be stolen,
+            // except for the critical ones, which are run right away
+            if (is_message<post_call>(msg) && local_worker->current_priority() != priority::critical)
+            {
+                local_worker->tasks.push(box_task(std::move(msg)));
+                record_local_depth();
+                wake_idle_worker();
+                return true;
+            }
+            // Finish all the tasks owned by the worker before breaking out of the loop
+            if (is_message<break_message>(msg))
+            {
+                message_ptr *task;
+                while (local_worker->tasks.pop(task))
+                    run_task(task);
+            }
+        }
+        if (is_message<post_call>(msg))
+        {
+            run_message(std::move(msg));
             return true;
         }
         return false;
     }
 
-    void thread_pool::send_message(message_ptr msg)
+    bool thread_pool::has_pending_tasks()
+    {
+        if (task_assigning_strategy == strategy::dynamic)
+        {
+            mutex_lock scope_lock(task_queue_lock);
+            for (const auto &queue : task_queues)
+                if (!queue.empty())
+                    return true;
+            return false;
+        }
+        for (const auto &worker : pool)
+            if (!worker.tasks.empty())
+                return true;
+        return false;
+    }
+
+    bool thread_pool::park_worker(thread_handler &worker, time_point_t deadline)
+    {
+        worker.idle.store(true);
+        ++idle_workers;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Recheck after announcing, so that the tasks created in the meantime are not missed
+        if (!has_pending_tasks())
+            worker.wait_for_message(deadline);
+        if (worker.idle.exchange(false))
+            --idle_workers;
+        return deadline == time_point_t::max() || !helper::is_after(deadline);
+    }
+
+    void thread_pool::wake_idle_worker()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!idle_workers.load())
+            return;
+        for (auto &worker : pool)
+        {
+            if (worker.idle.exchange(false))
+            {
+                --idle_workers;
+                worker.wake();
+                return;
+            }
+        }
+    }
+
+    bool thread_pool::steal_task(thread_handler &thief, message_ptr *&task)
+    {
+        if (processes < 2)
+            return false;
+        for (unsigned attempt = 0; attempt < processes; ++attempt)
+        {
+            thread_handler &victim = pool[thief.victim_rng() % processes];
+            if (&victim != &thief && victim.tasks.steal(task))
+            {
+                if (helper::scheduler_counters *counters = helper::scheduler_counters::current())
+                    counters->record_steal();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void thread_pool::run_task(message_ptr *task)
+    {
+        run_message(unbox_task(task));
+    }
+
+    bool thread_pool::pop_shared_task(message_ptr &task)
+    {
+        mutex_lock scope_lock(task_queue_lock);
+        return task_lanes.next([&](size_t lane)
+            {
+                if (task_queues[lane].empty())
+                    return false;
+                task = std::move(task_queues[lane].front());
+                task_queues[lane].pop();
+                return true;
+            }) != priority_levels;
+    }
+
+    void thread_pool::run_message(message_ptr msg)
+    {
+        task_started();
+        post_call *call = static_cast<post_call *>(msg.get());
+        if (cancelling.load(std::memory_order_relaxed))
+        {
+            // Dropping the task breaks its promise
+            call->function = nullptr;
+            return;
+        }
+        try
+        {
+            helper::task_timer timer;
+            call->function();
+        }
+        catch (std::exception &e)
+        {
+            handle_exception(std::current_exception());
+        }
+        call->function = nullptr;
+    }
+
+    bool thread_pool::reserve_slot(time_point_t deadline)
+    {
+        size_t limit = pending_limit.load();
+        if (limit == 0 || is_pool_thread())
+        {
+            ++pending_tasks;
+            return true;
+        }
+        size_t current = pending_tasks.load();
+        while (true)
+        {
+            while (current < limit)
+                if (pending_tasks.compare_exchange_weak(current, current + 1))
+                    return true;
+            if (deadline == time_point_t::min())
+                return false;
+
+            std::unique_lock<std::mutex> scope_lock(capacity_lock);
+            ++capacity_waiters;
+            auto has_capacity = [&]()
+                {
+                    limit = pending_limit.load();
+                    return limit == 0 || pending_tasks.load() < limit;
+                };
+            bool available = true;
+            if (deadline == time_point_t::max())
+                capacity_cv.wait(scope_lock, has_capacity);
+            else
+                available = capacity_cv.wait_until(scope_lock, deadline, has_capacity);
+            --capacity_waiters;
+            if (!available)
+                return false;
+            if (limit == 0)
+            {
+                ++pending_tasks;
+                return true;
+            }
+            current = pending_tasks.load();
+        }
+    }
+
+    void thread_pool::task_started()
+    {
+        --pending_tasks;
+        // Taking the lock guarantees that a producer is either already waiting, or yet to check the counter
+        if (capacity_waiters.load())
+        {
+            { mutex_lock scope_lock(capacity_lock); }
+            capacity_cv.notify_one();
+        }
+    }
+
+    std::default_random_engine &thread_pool::p2c_rng()
+    {
+        thread_local std::default_random_engine rng(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                                                    std::chrono::system_clock::now().time_since_epoch().count());
+        return rng;
+    }
+
+    void thread_pool::send_message(message_ptr msg, priority p)
+    {
+        ++pending_tasks;
+        dispatch_message(std::move(msg), p);
+    }
+
+    void thread_pool::dispatch_message(message_ptr msg, priority p)
     {
         switch (task_assigning_strategy)
         {
             case strategy::dynamic:
             {
-                mutex_lock scope_lock(task_queue_lock);
-                task_queue.push(msg);
+                {
+                    mutex_lock scope_lock(task_queue_lock);
+                    task_queues[helper::lane_of(p)].push(msg);
+                    record_shared_depth();
+                }
+                wake_idle_worker();
+                if (is_elastic())
+                    maybe_grow();
                 break;
             }
             case strategy::round_robin:
             {
-                next_robin->send_message(msg);
-                ++next_robin;
-                if (next_robin == pool.end()) next_robin = pool.begin();
+                pool[next_robin.fetch_add(1) % processes].send_message(msg, p);
                 break;
             };
             case strategy::power2choices:
             {
                 // select two workers at random
-                size_t index_0 = p2c_rng() % processes;
-                size_t index_1 = p2c_rng() % processes;
+                std::default_random_engine &rng = p2c_rng();
+                size_t index_0 = rng() % processes;
+                size_t index_1 = rng() % processes;
                 assert(index_0 >= 0);
                 assert(index_1 >= 0);
                 // select the one with a smaller message queue
                 size_t queue_0 = pool[index_0].count();
                 size_t queue_1 = pool[index_1].count();
                 // assign the work to the correct worker
-                pool[(queue_0 < queue_1) ? index_0 : index_1].send_message(msg);
+                pool[(queue_0 < queue_1) ? index_0 : index_1].send_message(msg, p);
+                break;
+            };
+            case strategy::work_stealing:
+            {
+                // Tasks created by the workers go directly to their own deques
+                if (is_local_worker())
+                {
+                    local_worker->tasks.push(box_task(std::move(msg)));
+                    record_local_depth();
+                    wake_idle_worker();
+                    break;
+                }
+                pool[next_robin.fetch_add(1) % processes].send_message(msg, p);
                 break;
             };
         }
     }
 
-    void thread_pool::initialize_queues()
+    void thread_pool::send_messages(std::vector<message_ptr> &batch, priority p)
+    {
+        size_t limit = pending_limit.load();
+        if (limit == 0 || is_pool_thread())
+        {
+            pending_tasks += batch.size();
+            dispatch_messages(batch.begin(), batch.end(), p);
+            return;
+        }
+        // Wait for a single slot, then take as many more as are free, and submit that part of the batch
+        batch_iterator first = batch.begin();
+        while (first != batch.end())
+        {
+            reserve_slot(time_point_t::max());
+            batch_iterator last = first + 1;
+            while (last != batch.end() && reserve_slot(time_point_t::min()))
+                ++last;
+            dispatch_messages(first, last, p);
+            first = last;
+        }
+    }
+
+    void thread_pool::dispatch_messages(batch_iterator first, batch_iterator last, priority p)
+    {
+        size_t n = last - first;
+        if (n == 0)
+            return;
+        std::vector<size_t> shares(processes, 0);
+        switch (task_assigning_strategy)
+        {
+            case strategy::dynamic:
+            {
+                {
+                    mutex_lock scope_lock(task_queue_lock);
+                    for (; first != last; ++first)
+                        task_queues[helper::lane_of(p)].push(std::move(*first));
+                    record_shared_depth();
+                }
+                for (size_t i = 0; i < std::min<size_t>(n, processes); ++i)
+                    wake_idle_worker();
+                if (is_elastic())
+                    for (size_t i = 0; i < std::min<size_t>(n, processes); ++i)
+                        maybe_grow();
+                return;
+            }
+            case strategy::power2choices:
+            {
+                // Fill up the shortest queues first, as if the tasks were assigned one by one to the least busy worker
+                typedef std::pair<size_t, unsigned> load_type;
+                std::priority_queue<load_type, std::vector<load_type>, std::greater<load_type>> loads;
+                for (unsigned i : range<unsigned>(processes))
+                    loads.push(load_type(pool[i].count(), i));
+                for (size_t i = 0; i < n; ++i)
+                {
+                    load_type least = loads.top();
+                    loads.pop();
+                    ++shares[least.second];
+                    ++least.first;
+                    loads.push(least);
+                }
+                break;
+            }
+            case strategy::work_stealing:
+            {
+                if (is_local_worker())
+                {
+                    for (; first != last; ++first)
+                        local_worker->tasks.push(box_task(std::move(*first)));
+                    record_local_depth();
+                    for (size_t i = 0; i < std::min<size_t>(n, processes - 1); ++i)
+                        wake_idle_worker();
+                    return;
+                }
+                // Tasks created from outside of the pool are posted in a round robin fashion
+            }
+            // fall through
+            case strategy::round_robin:
+            {
+                // The same assignment as if the tasks were posted one by one
+                size_t start = next_robin.fetch_add(n) % processes;
+                for (size_t i = 0; i < processes; ++i)
+                    shares[(start + i) % processes] = n / processes + (i < n % processes ? 1 : 0);
+                break;
+            }
+        }
+        post_shares(first, shares, p);
+    }
+
+    void thread_pool::post_shares(batch_iterator first, const std::vector<size_t> &shares, priority p)
     {
         for (unsigned i : range<unsigned>(processes))
-            pool[i].send_message(std::make_shared<empty_queue_guard>(i));
+        {
+            if (shares[i] == 0)
+                continue;
+            pool[i].send_messages(first, first + shares[i], p);
+            first += shares[i];
+        }
+    }
+
+    void thread_pool::start_worker(thread_handler &worker)
+    {
+        // Join the thread of a retired worker, before starting a new one
+        if (worker.joinable())
+            worker.wait_until_finished();
+        if (worker_cpus[worker.id] >= 0)
+            worker.send_message(std::make_shared<placement_message>(worker.id, worker_cpus[worker.id]));
+        // With static task assignment the workers simply block in their loopers, when out of work
+        if (task_assigning_strategy == strategy::dynamic || task_assigning_strategy == strategy::work_stealing)
+            worker.send_message(std::make_shared<empty_queue_guard>(worker.id));
+        worker.live = true;
+        ++live_workers;
+        worker.start();
+    }
+
+    void thread_pool::maybe_grow()
+    {
+        if (live_workers.load() >= processes || idle_workers.load() != 0)
+            return;
+        mutex_lock scope_lock(resize_lock);
+        if (resizing_stopped || live_workers.load() >= processes)
+            return;
+        for (auto &worker : pool)
+        {
+            if (!worker.live)
+            {
+                start_worker(worker);
+                return;
+            }
+        }
+    }
+
+    bool thread_pool::retire_worker(thread_handler &worker)
+    {
+        mutex_lock scope_lock(resize_lock);
+        if (resizing_stopped || live_workers.load() <= min_workers)
+            return false;
+        --live_workers;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // A task submitted in the meantime might have counted on this worker
+        if (has_pending_tasks() || !worker.empty())
+        {
+            ++live_workers;
+            return false;
+        }
+        worker.live = false;
+        worker.stop();
+        return true;
     }
 
     void thread_pool::stop_and_join()
     {
         throw_if_nonempty();
-        for (auto &i : pool)
+        shutdown(shutdown_mode::drain);
+        throw_if_nonempty();
+    }
+
+    void thread_pool::cancel_workers()
+    {
+        cancelling.store(true);
+        for (auto &worker : pool)
+            if (worker.live)
+                worker.stop();
+    }
+
+    void thread_pool::stop_resizing()
+    {
+        mutex_lock scope_lock(resize_lock);
+        resizing_stopped = true;
+    }
+
+    void thread_pool::join_workers()
+    {
+        for (auto &worker : pool)
+            if (worker.joinable())
+                worker.wait_until_finished();
+    }
+
+    void thread_pool::discard_pending()
+    {
+        // Broken promises may schedule continuations, which land in the queues again
+        bool discarded = true;
+        while (discarded)
         {
-            i.stop_and_join_safely();
-            throw_if_nonempty();
+            discarded = false;
+            for (auto &worker : pool)
+                discarded |= worker.discard_pending();
+            message_ptr task;
+            while (pop_shared_task(task))
+            {
+                task = nullptr;
+                discarded = true;
+            }
         }
     }
 
+    void thread_pool::shutdown(shutdown_mode mode)
+    {
+        continuation_handle->detach();
+        stop_resizing();
+        if (mode == shutdown_mode::cancel_pending)
+            cancel_workers();
+        else
+            for (auto &worker : pool)
+                if (worker.live)
+                    worker.stop_safely();
+        join_workers();
+        if (mode == shutdown_mode::cancel_pending)
+            discard_pending();
+    }
+
+    bool thread_pool::shutdown_until(time_point_t deadline)
+    {
+        continuation_handle->detach();
+        stop_resizing();
+        for (auto &worker : pool)
+            if (worker.live)
+                worker.stop_safely();
+        for (auto &worker : pool)
+        {
+            if (worker.joinable() && !worker.wait_until_finished(deadline))
+            {
+                cancel_workers();
+                join_workers();
+                discard_pending();
+                return false;
+            }
+        }
+        return true;
+    }
+
     void thread_pool::handle_exception(std::exception_ptr ptr)
     {
+        thread_handler *worker = current_worker();
+        if (worker != nullptr && worker->errors.push(ptr))
+            return;
         mutex_lock scope_lock(exception_queue_lock);
         exception_queue.push(ptr);
     }
 
+    bool thread_pool::pop_exception(std::exception_ptr &error)
+    {
+        for (auto &worker : pool)
+            if (worker.errors.pop(error))
+                return true;
+        if (exception_queue.empty())
+            return false;
+        error = exception_queue.front();
+        exception_queue.pop();
+        return true;
+    }
+
+    exception_list thread_pool::collect_exceptions()
+    {
+        exception_list errors;
+        mutex_lock scope_lock(exception_queue_lock);
+        std::exception_ptr error;
+        while (pop_exception(error))
+            errors.push_back(error);
+        return errors;
+    }
+
     void thread_pool::throw_if_nonempty()
     {
         std::exception_ptr e;
         {
             mutex_lock scope_lock(exception_queue_lock);
-            if (exception_queue.empty())
+            if (!pop_exception(e))
                 return;
-            e = exception_queue.front();
-            exception_queue.pop();
         }
         // TODO: (1) when implementing <bounce> mechanics, add checks for bouncable inheritance here and adapt the throw method.
         // TODO: (2) add another exception like rethrown_exception and throw it instead.
@@ -132,15 +629,31 @@ namespace mdl
     
     size_t thread_pool::get_awaiting_tasks() const
     {
-        switch (task_assigning_strategy)
-        {
-            case strategy::dynamic:
-                return task_queue.size();
-            default:
-                size_t tasks = 0;
-                for (const auto &thread : pool)
-                    tasks += thread.count();
-                return task_queue.size() + tasks;
-        }
+        return pending_tasks.load();
+    }
+
+    void thread_pool::record_local_depth()
+    {
+        if (helper::scheduler_counters *counters = helper::scheduler_counters::current())
+            counters->record_depth(local_worker->tasks.size());
+    }
+
+    void thread_pool::record_shared_depth()
+    {
+        size_t depth = 0;
+        for (const auto &queue : task_queues)
+            depth += queue.size();
+        if (depth > shared_high_water.load(std::memory_order_relaxed))
+            shared_high_water.store(depth, std::memory_order_relaxed);
+    }
+
+    thread_pool_metrics thread_pool::metrics() const
+    {
+        thread_pool_metrics result;
+        result.workers.reserve(pool.size());
+        for (const auto &worker : pool)
+            result.workers.push_back(worker.metrics());
+        result.shared_queue_high_water = shared_high_water.load(std::memory_order_relaxed);
+        return result;
     }
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+//
+// Created by marandil on 17.10.26.
+//
+
+#include <mdlutils/multithreading/topology.hpp>
+
+#include <set>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+namespace mdl
+{
+    namespace helper
+    {
+        namespace
+        {
+            int read_sysfs_int(const std::string &path, int fallback)
+            {
+                std::ifstream file(path);
+                int value;
+                if (file >> value)
+                    return value;
+                return fallback;
+            }
+
+            // Parse a sysfs CPU list, e.g. "0-3,8,10-11".
+            std::vector<int> read_sysfs_list(const std::string &path)
+            {
+                std::vector<int> result;
+                std::ifstream file(path);
+                std::string list;
+                if (!(file >> list))
+                    return result;
+                size_t pos = 0;
+                while (pos < list.size())
+                {
+                    size_t end = list.find(',', pos);
+                    if (end == std::string::npos) end = list.size();
+                    std::string item = list.substr(pos, end - pos);
+                    size_t dash = item.find('-');
+                    int first = std::stoi(item.substr(0, dash));
+                    int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+                    for (int i = first; i <= last; ++i)
+                        result.push_back(i);
+                    pos = end + 1;
+                }
+                return result;
+            }
+
+            // Order of the hardware thread within its core (0 for the first sibling).
+            std::vector<int> sibling_ranks(const std::vector<cpu_info> &cpus)
+            {
+                std::vector<int> ranks(cpus.size(), 0);
+                for (size_t i = 0; i < cpus.size(); ++i)
+                    for (size_t j = 0; j < i; ++j)
+                        if (cpus[j].package == cpus[i].package && cpus[j].core == cpus[i].core)
+                            ++ranks[i];
+                return ranks;
+            }
+        }
+
+        std::vector<cpu_info> cpu_topology()
+        {
+            std::vector<cpu_info> result;
+#ifdef __linux__
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+                return result;
+
+            // Map the CPUs to the NUMA nodes, all CPUs belong to node 0 if there is no information
+            std::vector<int> nodes(CPU_SETSIZE, 0);
+            for (int node : read_sysfs_list("/sys/devices/system/node/online"))
+                for (int cpu : read_sysfs_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))
+                    if (cpu >= 0 && cpu < CPU_SETSIZE)
+                        nodes[cpu] = node;
+
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (!CPU_ISSET(cpu, &allowed))
+                    continue;
+                std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+                result.push_back(cpu_info{cpu, read_sysfs_int(topology + "physical_package_id", 0),
+                                          read_sysfs_int(topology + "core_id", cpu), nodes[cpu]});
+            }
+#endif
+            return result;
+        }
+
+        std::vector<int> plan_placement(const std::vector<cpu_info> &cpus, placement_policy policy, unsigned workers)
+        {
+            std::vector<int> result(workers, -1);
+            if (policy == placement_policy::none || cpus.empty())
+                return result;
+
+            std::vector<int> ranks = sibling_ranks(cpus);
+            std::vector<size_t> order;
+            for (size_t i = 0; i < cpus.size(); ++i)
+                if (policy != placement_policy::physical_cores || ranks[i] == 0)
+                    order.push_back(i);
+
+            if (policy == placement_policy::scatter)
+            {
+                // Index of the core within its package, so that the packages can be interleaved
+                std::vector<int> core_index(cpus.size(), 0);
+                for (size_t i = 0; i < cpus.size(); ++i)
+                {
+                    std::set<int> cores;
+                    for (size_t j = 0; j < cpus.size(); ++j)
+                        if (cpus[j].package == cpus[i].package && cpus[j].core < cpus[i].core)
+                            cores.insert(cpus[j].core);
+                    core_index[i] = static_cast<int>(cores.size());
+                }
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                    {
+                        if (ranks[a] != ranks[b]) return ranks[a] < ranks[b];
+                        if (core_index[a] != core_index[b]) return core_index[a] < core_index[b];
+                        return cpus[a].package < cpus[b].package;
+                    });
+            }
+            else
+            {
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                    {
+                        if (cpus[a].package != cpus[b].package) return cpus[a].package < cpus[b].package;
+                        if (cpus[a].core != cpus[b].core) return cpus[a].core < cpus[b].core;
+                        return ranks[a] < ranks[b];
+                    });
+            }
+
+            for (unsigned i = 0; i < workers; ++i)
+                result[i] = cpus[order[i % order.size()]].cpu;
+            return result;
+        }
+
+        bool pin_current_thread(int cpu)
+        {
+#ifdef __linux__
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+                return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            return false;
+#endif
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
 #include <mdlutils/typedefs.hpp>
 #include <mdlutils/accessor.hpp>
@@ -10,11 +13,82 @@
 #include <mdlutils/timeit.hpp>
 
 #include <mdlutils/types/const_vector.hpp>
+#include <mdlutils/memory/arena_allocator.hpp>
 
 #include <mdlutils/multithreading/thread_pool.hpp>
 
 std::vector<int> topofn_test_data;
 
+// Number of calls to the global operator new, used to count the allocations per submitted task. Counted only while
+// counting_allocations is set, so that the other benchmarks do not pay for the shared counter.
+std::atomic<size_t> global_allocations{0};
+std::atomic_bool counting_allocations{false};
+
+void *operator new(size_t size)
+{
+    if (counting_allocations.load(std::memory_order_relaxed))
+        global_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+// Submission path used by thread_pool::async before the task pooling: shared promise, std::function, shared message.
+template<typename Fn, typename T = typename std::result_of<Fn()>::type>
+std::future<T> legacy_async(mdl::looper &worker, Fn fn)
+{
+    std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+    std::function<void()> function = [promise, fn](void) mutable
+        { promise->set_value(fn()); };
+    worker.send_message(std::make_shared<mdl::post_call>(std::move(function)));
+    return promise->get_future();
+}
+
+template<typename Future, typename Submit>
+double allocations_per_task(Submit submit, unsigned count)
+{
+    std::vector<Future> results;
+    results.reserve(count);
+    // Warm up the pools, so that only the steady state is measured
+    for (unsigned i = 0; i < count; ++i)
+        results.push_back(submit(i));
+    for (auto &r : results) r.get();
+    results.clear();
+
+    size_t before = global_allocations.load();
+    counting_allocations = true;
+    for (unsigned i = 0; i < count; ++i)
+        results.push_back(submit(i));
+    for (auto &r : results) r.get();
+    counting_allocations = false;
+    size_t after = global_allocations.load();
+    results.clear();
+    return double(after - before) / count;
+}
+
+void bench_task_allocations()
+{
+    const unsigned count = 10000;
+    {
+        mdl::looper_thread worker;
+        std::cout << "Allocations per task : legacy: "
+                  << allocations_per_task<std::future<int>>([&](unsigned i) { return legacy_async(worker, [i] { return int(i); }); },
+                                          count)
+                  << std::endl;
+    }
+    {
+        mdl::thread_pool workers(1);
+        std::cout << "                       async:  "
+                  << allocations_per_task<mdl::future<int>>([&](unsigned i) { return workers.async([i] { return int(i); }); }, count)
+                  << std::endl;
+    }
+}
+
 void time_topofn_set()
 {
     auto k = mdl::top_of_n_set(topofn_test_data.begin(), topofn_test_data.end(), 100, std::greater<int>());
@@ -33,6 +107,13 @@ void time_topofn_vector()
     k.clear();
 }
 
+void time_topofn_parallel()
+{
+    static mdl::thread_pool pool;
+    auto k = mdl::parallel_top_of_n(pool, topofn_test_data.begin(), topofn_test_data.end(), 100, std::greater<int>());
+    k.clear();
+}
+
 void time_sorted_list()
 {
     mdl::sorted_list<int> test;
@@ -41,6 +122,44 @@ void time_sorted_list()
     test.clear();
 }
 
+void time_sorted_arena()
+{
+    mdl::sorted_list<int, std::less<int>, mdl::arena_allocator<int>> test;
+    for (int i : topofn_test_data)
+        test.insert(i);
+    test.clear();
+}
+
+void time_sorted_indexed()
+{
+    mdl::sorted_list<int, std::less<int>, std::allocator<int>, mdl::indexed_list_backend> test;
+    for (int i : topofn_test_data)
+        test.insert(i);
+    test.clear();
+}
+
+void time_sorted_flat()
+{
+    mdl::sorted_list<int, std::less<int>, std::allocator<int>, mdl::flat_backend> test;
+    for (int i : topofn_test_data)
+        test.insert(i);
+    test.clear();
+}
+
+void time_sorted_tree()
+{
+    mdl::sorted_list<int, std::less<int>, std::allocator<int>, mdl::btree_backend<>> test;
+    for (int i : topofn_test_data)
+        test.insert(i);
+    test.clear();
+}
+
+void time_sorted_bulk()
+{
+    mdl::sorted_list<int> test(topofn_test_data.begin(), topofn_test_data.end());
+    test.clear();
+}
+
 void time_sorted_set()
 {
     std::set<int> test;
@@ -106,6 +225,8 @@ int main()
         mdl::timeitv(time_topofn_list);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel);
     }
     {
         std::cout << "Top of N : sets: ";
@@ -114,12 +235,24 @@ int main()
         mdl::timeitv(time_topofn_list, 500);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector, 500);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel, 500);
     }
     {
         std::cout << "Sorted   : sets: ";
         mdl::timeitv(time_sorted_set);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect);
     }
@@ -128,6 +261,16 @@ int main()
         mdl::timeitv(time_sorted_set, 10);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list, 10);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena, 10);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed, 10);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat, 10);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree, 10);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk, 10);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect, 10);
     }
@@ -146,6 +289,8 @@ int main()
         mdl::timeitv(time_topofn_list);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel);
     }
     {
         std::cout << "Top of N : sets: ";
@@ -154,12 +299,24 @@ int main()
         mdl::timeitv(time_topofn_list, 500);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector, 500);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel, 500);
     }
     {
         std::cout << "Sorted   : sets: ";
         mdl::timeitv(time_sorted_set);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect);
     }
@@ -168,6 +325,16 @@ int main()
         mdl::timeitv(time_sorted_set, 10);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list, 10);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena, 10);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed, 10);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat, 10);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree, 10);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk, 10);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect, 10);
     }
@@ -186,6 +353,8 @@ int main()
         mdl::timeitv(time_topofn_list);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel);
     }
     {
         std::cout << "Top of N : sets: ";
@@ -194,12 +363,24 @@ int main()
         mdl::timeitv(time_topofn_list, 500);
         std::cout << "           vect: ";
         mdl::timeitv(time_topofn_vector, 500);
+        std::cout << "           para: ";
+        mdl::timeitv(time_topofn_parallel, 500);
     }
     {
         std::cout << "Sorted   : sets: ";
         mdl::timeitv(time_sorted_set);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect);
     }
@@ -208,6 +389,16 @@ int main()
         mdl::timeitv(time_sorted_set, 10);
         std::cout << "           list: ";
         mdl::timeitv(time_sorted_list, 10);
+        std::cout << "           arna: ";
+        mdl::timeitv(time_sorted_arena, 10);
+        std::cout << "           indx: ";
+        mdl::timeitv(time_sorted_indexed, 10);
+        std::cout << "           flat: ";
+        mdl::timeitv(time_sorted_flat, 10);
+        std::cout << "           tree: ";
+        mdl::timeitv(time_sorted_tree, 10);
+        std::cout << "           bulk: ";
+        mdl::timeitv(time_sorted_bulk, 10);
         std::cout << "           vect: ";
         mdl::timeitv(time_sorted_vect, 10);
     }
@@ -254,6 +445,7 @@ int main()
         mdl::thread_pool workers;
         std::cout << "Created a thread_pool with " << workers.workers << " workers" << std::endl;
     }
+    bench_task_allocations();
     {
         mdl::const_vector<int> c(10);
         std::vector<int> v(10);